@@ -0,0 +1,246 @@
+// AUTHOR:      Hongru He
+// FILENAME:    bottleneckanalyzer.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "bottleneckanalyzer.h"
+#include "plandag.h"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   One forward pass in the order of the PlanDAG gives the earliest
+//      starts and one backward pass the latest starts, with joins taking
+//      no time; critical[s] remembers the predecessor that decided a
+//      node's earliest start, and joins are left out of the critical path.
+// 2.   The shortage pass adds outputs at the yield of the mode, and only
+//      subtracts inputs when consuming. cause[m] holds the root materials of the last blocked step
+//      that should have produced m, and is empty once a step has produced
+//      it. charged[r] is the last step charged to root r.
+// 3.   Quantities are read from the Stockpile in one pass before the
+//      shortage pass, so each material costs one lookup.
+
+namespace {
+    const double EPSILON = 1e-9;
+}
+
+// Overloaded Constructor
+bottleneckanalyzer::bottleneckanalyzer(const plan& source,
+                                       const stockpile& resources,
+                                       yieldmode mode, bool consume) {
+    Analyze(source, resources, vector<double>(source.QuerySize(), 1), mode,
+            consume);
+}
+
+// Overloaded Constructor
+bottleneckanalyzer::bottleneckanalyzer(const plan& source,
+                                       const stockpile& resources,
+                                       const vector<double>& durations,
+                                       yieldmode mode, bool consume) {
+    if ((int) durations.size() != source.QuerySize()) {
+        throw invalid_argument("There must be one duration per step.");
+    }
+    for (double duration : durations) {
+        if (duration < 0) {
+            throw invalid_argument("A duration cannot be negative.");
+        }
+    }
+    Analyze(source, resources, durations, mode, consume);
+}
+
+// Analyze
+void bottleneckanalyzer::Analyze(const plan& source,
+                                 const stockpile& resources,
+                                 const vector<double>& durations,
+                                 yieldmode mode, bool consume) {
+    int n = source.QuerySize();
+    plandag dag(source);
+
+    // Earliest starts and the predecessor on the longest chain; a join
+    // takes no time
+    int nodes = dag.QueryNodeCount();
+    const vector<int>& order = dag.QueryOrder();
+    auto duration = [&](int node) {
+        return node < n ? durations[node] : 0.0;
+    };
+    vector<double> start(nodes, 0);
+    vector<int> critical(nodes, -1);
+    int last = -1;
+    for (int s : order) {
+        for (int p : dag.QueryPredecessors(s)) {
+            double finish = start[p] + duration(p);
+            if (finish > start[s]) {
+                start[s] = finish;
+                critical[s] = p;
+            }
+        }
+        double finish = start[s] + duration(s);
+        if (s < n && (last < 0 || finish > makespan)) {
+            makespan = finish;
+            last = s;
+        }
+    }
+    earliestStart.assign(start.begin(), start.begin() + n);
+
+    // Latest starts give the slack
+    vector<double> latestStart(nodes);
+    for (auto s = order.rbegin(); s != order.rend(); ++s) {
+        double latestFinish = makespan;
+        for (int next : dag.QuerySuccessors(*s)) {
+            latestFinish = min(latestFinish, latestStart[next]);
+        }
+        latestStart[*s] = latestFinish - duration(*s);
+    }
+    slack.resize(n);
+    for (int s = 0; s < n; s++) {
+        slack[s] = max(latestStart[s] - earliestStart[s], 0.0);
+    }
+
+    criticalPath.clear();
+    for (int s = last; s >= 0; s = critical[s]) {
+        if (s < n) {
+            criticalPath.push_back(s);
+        }
+    }
+    reverse(criticalPath.begin(), criticalPath.end());
+
+    // Run the Plan once and charge every blocked step to a root material
+    unordered_map<string, int> materialIds;
+    vector<string> names;
+    vector<vector<pair<int, int>>> inputs(n);
+    vector<vector<pair<int, int>>> outputs(n);
+    auto intern = [&](const string& name) {
+        auto item = materialIds.emplace(name, (int) names.size());
+        if (item.second) {
+            names.push_back(name);
+        }
+        return item.first->second;
+    };
+    for (int s = 0; s < n; s++) {
+        const formula& step = source.QueryFormula(s);
+        for (int i = 0; i < step.QueryInputSize(); i++) {
+            inputs[s].push_back({intern(step.QueryInputMaterial(i)),
+                                 step.QueryInputNumber(i)});
+        }
+        for (int j = 0; j < step.QueryOutputSize(); j++) {
+            outputs[s].push_back({intern(step.QueryOutputMaterial(j)),
+                                  step.QueryOutputNumber(j)});
+        }
+    }
+    vector<double> quantity(names.size(), 0);
+    resources.ForEachResource([&](const string& name, double amount) {
+        auto item = materialIds.find(name);
+        if (item != materialIds.end()) {
+            quantity[item->second] = amount;
+        }
+    });
+
+    vector<vector<int>> cause(names.size());
+    vector<int> charged(names.size(), -1);
+    vector<int> blockedBy(names.size(), 0);
+    vector<double> deficit(names.size(), 0);
+    blocked.assign(n, 0);
+    for (int s = 0; s < n; s++) {
+        // Every short input charges its roots, each root once per step
+        vector<int> roots;
+        auto charge = [&](int root) {
+            if (charged[root] != s) {
+                charged[root] = s;
+                roots.push_back(root);
+            }
+        };
+        for (const pair<int, int>& input : inputs[s]) {
+            double missing = input.second - quantity[input.first];
+            if (missing <= EPSILON) {
+                continue;
+            }
+            if (!cause[input.first].empty()) {
+                for (int root : cause[input.first]) {
+                    charge(root);
+                }
+            }
+            else {
+                charge(input.first);
+                deficit[input.first] += missing;
+            }
+        }
+
+        if (!roots.empty()) {
+            blocked[s] = 1;
+            for (int root : roots) {
+                blockedBy[root]++;
+            }
+            for (const pair<int, int>& output : outputs[s]) {
+                cause[output.first] = roots;
+            }
+            continue;
+        }
+        if (consume) {
+            for (const pair<int, int>& input : inputs[s]) {
+                quantity[input.first] -= input.second;
+            }
+        }
+        double factor = craftabilitysolver::QueryYield(
+                source.QueryFormula(s), mode);
+        for (const pair<int, int>& output : outputs[s]) {
+            quantity[output.first] += output.second * factor;
+            cause[output.first].clear();
+        }
+    }
+
+    shortages.clear();
+    for (size_t m = 0; m < names.size(); m++) {
+        if (blockedBy[m] > 0) {
+            shortages.push_back({names[m], blockedBy[m], deficit[m]});
+        }
+    }
+    sort(shortages.begin(), shortages.end(),
+         [](const materialshortage& a, const materialshortage& b) {
+             if (a.blockedSteps != b.blockedSteps) {
+                 return a.blockedSteps > b.blockedSteps;
+             }
+             return a.material < b.material;
+         });
+}
+
+// Query Makespan
+double bottleneckanalyzer::QueryMakespan() const {
+    return makespan;
+}
+
+// Query Critical Path
+const vector<int>& bottleneckanalyzer::QueryCriticalPath() const {
+    return criticalPath;
+}
+
+// Query Earliest Start
+double bottleneckanalyzer::QueryEarliestStart(int step) const {
+    if (step < 0 || step >= (int) earliestStart.size()) {
+        throw out_of_range("Index out of range.");
+    }
+    return earliestStart[step];
+}
+
+// Query Slack
+double bottleneckanalyzer::QuerySlack(int step) const {
+    if (step < 0 || step >= (int) slack.size()) {
+        throw out_of_range("Index out of range.");
+    }
+    return slack[step];
+}
+
+// Query Blocked
+bool bottleneckanalyzer::QueryBlocked(int step) const {
+    if (step < 0 || step >= (int) blocked.size()) {
+        throw out_of_range("Index out of range.");
+    }
+    return blocked[step];
+}
+
+// Query Shortages
+const vector<materialshortage>& bottleneckanalyzer::QueryShortages() const {
+    return shortages;
+}
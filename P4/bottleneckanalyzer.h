@@ -0,0 +1,92 @@
+// AUTHOR:      Hongru He
+// FILENAME:    bottleneckanalyzer.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_BOTTLENECKANALYZER_H
+#define P4_BOTTLENECKANALYZER_H
+#include "craftabilitysolver.h"
+#include "plan.h"
+#include "stockpile.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A material whose shortage keeps steps of a Plan from running.
+struct materialshortage {
+    string material;
+    int blockedSteps = 0;   // Steps blocked by it, directly or downstream
+    double deficit = 0;     // Missing quantity when steps asked for it
+};
+
+// The BottleneckAnalyzer class finds what limits a Plan. Timing comes from
+// the PlanDAG: the critical path is the longest chain of dependent steps,
+// and a step's slack is how long it can be delayed without delaying the
+// whole Plan. Shortages come from running the Plan once against the
+// Stockpile, where a step short of an input is blocked and produces
+// nothing. Like ExecutablePlan::Apply, a step only checks its inputs unless
+// the analysis is asked to consume them.
+// Class Invariants:
+// 1.   Every step takes its duration, 1 unless durations are given, and
+//      starts as soon as the steps it depends on have finished.
+// 2.   A blocked step is charged once to every material that started a
+//      chain of shortages into it: each input the Stockpile lacked, and
+//      the roots of the blocked steps that should have produced the others.
+//      A step short of several materials counts for each of them.
+// 3.   The analysis is linear in the size of the Plan: the PlanDAG joins
+//      groups of steps instead of linking every pair, so its edges are
+//      linear too.
+
+class bottleneckanalyzer {
+private:
+    vector<double> earliestStart;
+    vector<double> slack;
+    vector<int> criticalPath;
+    vector<char> blocked;
+    vector<materialshortage> shortages;
+    double makespan = 0;
+
+    void Analyze(const plan&, const stockpile&, const vector<double>&,
+                 yieldmode, bool);
+    // Run the timing and the shortage analysis
+
+public:
+    bottleneckanalyzer(const plan&, const stockpile&,
+                       yieldmode = yieldmode::Nominal, bool = false);
+    // Overloaded Constructor
+    // Explanation:     Analyzes a Plan whose steps all take 1 unit of time.
+    //                  Steps consume their inputs only if the flag is set.
+    // Precondition:    None.
+    // Postcondition:   The analysis is ready to query.
+
+    bottleneckanalyzer(const plan&, const stockpile&, const vector<double>&,
+                       yieldmode = yieldmode::Nominal, bool = false);
+    // Overloaded Constructor
+    // Explanation:     Analyzes a Plan with the duration of every step.
+    //                  Steps consume their inputs only if the flag is set.
+    // Precondition:    There is one duration per step, none negative;
+    //                  otherwise an invalid_argument exception is thrown.
+    // Postcondition:   The analysis is ready to query.
+
+    double QueryMakespan() const;
+    // Get the time the Plan takes with unlimited parallelism
+
+    const vector<int>& QueryCriticalPath() const;
+    // Get the steps of the critical path in the order they run
+
+    double QueryEarliestStart(int) const;
+    // Get the earliest time a step can start
+
+    double QuerySlack(int) const;
+    // Get how long a step can be delayed without delaying the Plan
+
+    bool QueryBlocked(int) const;
+    // Check if a step is blocked by a shortage
+
+    const vector<materialshortage>& QueryShortages() const;
+    // Get the materials that block steps, the most blocking first
+};
+
+
+#endif //P4_BOTTLENECKANALYZER_H
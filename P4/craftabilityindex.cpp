@@ -0,0 +1,134 @@
+// AUTHOR:      Hongru He
+// FILENAME:    craftabilityindex.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "craftabilityindex.h"
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   counts[id] is -1 for an id that is not tracked; every other entry is
+//      also in the ranking as (count, id).
+// 2.   The catalog's MaterialIndex finds the consumers of a changed
+//      material, so one mutation costs O(consumers x inputs) lookups.
+// 3.   Stockpile::QueryQuantity truncates to an int, which does not change
+//      floor(quantity / number) for a positive integer number.
+
+// Overloaded Constructor
+craftabilityindex::craftabilityindex(const recipecatalog& recipes,
+                                     stockpile& resources) {
+    catalog = &recipes;
+    stock = &resources;
+    for (int id = 0; id < catalog->QueryIdLimit(); id++) {
+        if (catalog->QueryContains(id)) {
+            Track(id);
+        }
+    }
+}
+
+// Destructor
+craftabilityindex::~craftabilityindex() {
+    for (int watcherId : watcherIds) {
+        stock->Unwatch(watcherId);
+    }
+}
+
+// Count Craftable
+// Takes the minimum over the inputs of quantity / number, rounded down; an
+// input whose number is not positive never runs out
+long long craftabilityindex::CountCraftable(const formula& recipe) const {
+    long long result = QueryUnlimited();
+    for (int i = 0; i < recipe.QueryInputSize() && result > 0; i++) {
+        int number = recipe.QueryInputNumber(i);
+        if (number <= 0) {
+            continue;
+        }
+        int quantity = stock->QueryQuantity(recipe.QueryInputMaterial(i));
+        long long times = quantity > 0 ? quantity / number : 0;
+        result = min(result, times);
+    }
+    return result;
+}
+
+// Refresh
+// Moves the recipe to its new place in the ranking if its count changed
+void craftabilityindex::Refresh(int id) {
+    long long count = CountCraftable(catalog->QueryFormula(id));
+    if (count != counts[id]) {
+        ranking.erase({counts[id], id});
+        counts[id] = count;
+        ranking.insert({count, id});
+    }
+}
+
+// On Change
+// Refreshes the tracked recipes that consume the changed material
+void craftabilityindex::OnChange(const string& material) {
+    for (int id : catalog->QueryConsumers(material)) {
+        if (id < (int) counts.size() && counts[id] >= 0) {
+            Refresh(id);
+        }
+    }
+}
+
+// Track
+// Computes the recipe's count and watches the inputs not watched yet
+void craftabilityindex::Track(int id) {
+    const formula& recipe = catalog->QueryFormula(id);
+    if (id >= (int) counts.size()) {
+        counts.resize(catalog->QueryIdLimit(), -1);
+    }
+    if (counts[id] >= 0) {
+        return;
+    }
+
+    vector<string> newMaterials;
+    for (int i = 0; i < recipe.QueryInputSize(); i++) {
+        if (watchedMaterials.insert(recipe.QueryInputMaterial(i)).second) {
+            newMaterials.push_back(recipe.QueryInputMaterial(i));
+        }
+    }
+    if (!newMaterials.empty()) {
+        watcherIds.push_back(stock->WatchChanges(newMaterials,
+                [this](const string& material, double, double) {
+                    OnChange(material);
+                }));
+    }
+
+    counts[id] = CountCraftable(recipe);
+    ranking.insert({counts[id], id});
+}
+
+// Untrack
+void craftabilityindex::Untrack(int id) {
+    if (id >= 0 && id < (int) counts.size() && counts[id] >= 0) {
+        ranking.erase({counts[id], id});
+        counts[id] = -1;
+    }
+}
+
+// Query Craftable
+long long craftabilityindex::QueryCraftable(int id) const {
+    if (id < 0 || id >= (int) counts.size() || counts[id] < 0) {
+        throw out_of_range("The recipe is not tracked.");
+    }
+    return counts[id];
+}
+
+// Query Top K
+vector<pair<int, long long>> craftabilityindex::QueryTopK(int k) const {
+    vector<pair<int, long long>> result;
+    for (auto item = ranking.begin();
+         item != ranking.end() && (int) result.size() < k; ++item) {
+        result.push_back({item->second, item->first});
+    }
+    return result;
+}
+
+// Query Unlimited
+long long craftabilityindex::QueryUnlimited() {
+    return numeric_limits<long long>::max();
+}
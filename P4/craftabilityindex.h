@@ -0,0 +1,99 @@
+// AUTHOR:      Hongru He
+// FILENAME:    craftabilityindex.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_CRAFTABILITYINDEX_H
+#define P4_CRAFTABILITYINDEX_H
+#include "recipecatalog.h"
+#include "stockpile.h"
+#include <functional>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The CraftabilityIndex class keeps, for every tracked recipe of a
+// RecipeCatalog, how many times it can be crafted from a Stockpile right now:
+// floor(min over inputs of quantity / required number).
+// Class Invariants:
+// 1.   The count of every tracked recipe matches the Stockpile after each
+//      mutation; a mutation only recomputes the recipes that consume the
+//      changed material.
+// 2.   The ranking holds exactly the tracked recipes, ordered by count from
+//      the most craftable down, and by descending id among equal counts.
+// 3.   An input whose required number is not positive does not limit the
+//      count, so a recipe without any other input can be crafted
+//      QueryUnlimited() times.
+
+class craftabilityindex {
+private:
+    const recipecatalog* catalog;
+    stockpile* stock;
+    vector<long long> counts;
+    set<pair<long long, int>, greater<pair<long long, int>>> ranking;
+    unordered_set<string> watchedMaterials;
+    vector<int> watcherIds;
+
+    long long CountCraftable(const formula&) const;
+    // Compute the craftable count of a recipe from the Stockpile
+
+    void Refresh(int);
+    // Recompute a tracked recipe and move it in the ranking
+
+    void OnChange(const string&);
+    // Refresh every tracked recipe that consumes the changed material
+
+public:
+    craftabilityindex(const recipecatalog&, stockpile&);
+    // Overloaded Constructor
+    // Explanation:     Tracks every recipe in the catalog and watches the
+    //                  Stockpile for changes to their inputs.
+    // Precondition:    The catalog and the Stockpile outlive the index, and
+    //                  the Stockpile is not moved while the index exists.
+    // Postcondition:   CraftabilityIndex object holds the current counts.
+
+    ~craftabilityindex();
+    // Destructor
+    // Explanation:     Removes the index's watchers from the Stockpile.
+    // Precondition:    None.
+    // Postcondition:   The Stockpile no longer calls the index.
+
+    craftabilityindex(const craftabilityindex&) = delete;
+    craftabilityindex& operator=(const craftabilityindex&) = delete;
+
+    void Track(int);
+    // Track a recipe added to the catalog after the index was built
+    // Explanation:     Computes its count and watches any new input.
+    // Precondition:    The id names a recipe in the catalog; otherwise an
+    //                  out_of_range exception is thrown.
+    // Postcondition:   The recipe is tracked.
+
+    void Untrack(int);
+    // Stop tracking a recipe
+    // Explanation:     Call this before removing the recipe from the
+    //                  catalog.
+    // Precondition:    None.
+    // Postcondition:   The recipe is no longer tracked.
+
+    long long QueryCraftable(int) const;
+    // Get how many times a recipe can be crafted
+    // Precondition:    The recipe is tracked; otherwise an out_of_range
+    //                  exception is thrown.
+
+    vector<pair<int, long long>> QueryTopK(int) const;
+    // Get the most craftable recipes
+    // Explanation:     Walks the ranking from the top, in O(k).
+    // Precondition:    None.
+    // Postcondition:   Return up to k pairs of recipe id and count, most
+    //                  craftable first.
+
+    static long long QueryUnlimited();
+    // Get the count of a recipe without inputs
+};
+
+
+#endif //P4_CRAFTABILITYINDEX_H
@@ -0,0 +1,304 @@
+// AUTHOR:      Hongru He
+// FILENAME:    craftabilitysolver.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "craftabilitysolver.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Materials are interned to node ids once per query. A node's state is
+//      0 before Solve reaches it, 1 while it is on the Solve path and 2
+//      once its bound and producer are final; an input still at 1 closes a
+//      cycle and only counts with its stock.
+// 2.   The bound of a node is its stock plus the most its producer could
+//      make if every input reached its own bound. It ignores that inputs
+//      share materials, so it is an upper bound for the binary search.
+// 3.   Feasible walks scratch.order, in which every material comes before
+//      the inputs of its producer (except across a cut cycle). Demand is
+//      taken from stock first and the rest is crafted in whole crafts.
+//      Demand on a material that is already settled can only be met from
+//      its leftover stock.
+// 4.   Worker threads only read the memo; each owns its scratch.
+
+namespace {
+    // Bounds are capped so that crafts * number stays exact in a double.
+    const double MAXBOUND = 1e15;
+    const double EPSILON = 1e-9;
+}
+
+// Overloaded Constructor
+craftabilitysolver::craftabilitysolver(const recipecatalog& recipes,
+                                       yieldmode yieldMode) {
+    catalog = &recipes;
+    mode = yieldMode;
+}
+
+// Query Yield
+// Returns the output multiplier of one craft under the yield mode
+double craftabilitysolver::QueryYield(const formula& recipe,
+                                      yieldmode yieldMode) {
+    if (yieldMode == yieldmode::Expected) {
+        return recipe.QueryExpectedYield();
+    }
+    if (yieldMode == yieldmode::Pessimistic) {
+        return formula::QueryTierMultiplier(1);
+    }
+    return formula::QueryTierMultiplier(2);
+}
+
+// Prepare
+// Reads the Stockpile once and forgets the memo of the previous query
+void craftabilitysolver::Prepare(const stockpile& resources) {
+    nodes.clear();
+    nodeIds.clear();
+    quantities.clear();
+    resources.ForEachResource([this](const string& name, double quantity) {
+        quantities[name] = quantity;
+    });
+}
+
+// Solve
+// Computes the bound and the chosen producer of a material by memoized DFS.
+// The DFS keeps its own stack of frames, one per material being solved, so
+// recipe chains of any depth cannot overflow the call stack.
+int craftabilitysolver::Solve(const string& target) {
+    auto item = nodeIds.find(target);
+    if (item != nodeIds.end()) {
+        return item->second;
+    }
+
+    struct frame {
+        int id;
+        string material;
+        size_t producer = 0;
+        int input = 0;
+        double yield = 0;
+        double crafts = MAXBOUND;
+        double bestGain = 0;
+        vector<pair<int, int>> inputs;
+    };
+
+    vector<frame> path;
+    auto open = [this, &path](const string& material) {
+        int id = (int) nodes.size();
+        nodeIds.emplace(material, id);
+        nodes.emplace_back();
+        auto stock = quantities.find(material);
+        nodes[id].stock = stock == quantities.end() ? 0 :
+                          max(stock->second, 0.0);
+        nodes[id].state = 1;
+        path.emplace_back();
+        path.back().id = id;
+        path.back().material = material;
+    };
+
+    open(target);
+    int result = path[0].id;
+    while (!path.empty()) {
+        frame& top = path.back();
+        const vector<int>& producers = catalog->QueryProducers(top.material);
+        if (top.producer == producers.size()) {
+            node& current = nodes[top.id];
+            current.bound = min(current.stock + top.bestGain, MAXBOUND);
+            current.state = 2;
+            path.pop_back();
+            continue;
+        }
+
+        int recipeId = producers[top.producer];
+        const formula& recipe = catalog->QueryFormula(recipeId);
+        if (top.yield == 0) {
+            int outputNumber = 0;
+            for (int j = 0; j < recipe.QueryOutputSize(); j++) {
+                if (recipe.QueryOutputMaterial(j) == top.material) {
+                    outputNumber += recipe.QueryOutputNumber(j);
+                }
+            }
+            double yield = outputNumber * QueryYield(recipe, mode);
+            if (yield <= 0) {
+                top.producer++;
+                continue;
+            }
+            top.yield = yield;
+            top.crafts = MAXBOUND;
+            top.input = 0;
+            top.inputs.clear();
+        }
+
+        // Solve the next input first, then come back to this frame
+        if (top.input < recipe.QueryInputSize()) {
+            const string& name = recipe.QueryInputMaterial(top.input);
+            auto found = nodeIds.find(name);
+            if (found == nodeIds.end()) {
+                open(name);
+                continue;
+            }
+            int input = found->second;
+            int number = recipe.QueryInputNumber(top.input);
+            double available = nodes[input].state == 2 ?
+                    nodes[input].bound : nodes[input].stock;
+            top.crafts = min(top.crafts, floor(available / number));
+            top.inputs.push_back({input, number});
+            top.input++;
+            continue;
+        }
+
+        double gain = min(top.crafts * top.yield, MAXBOUND);
+        if (gain > top.bestGain) {
+            top.bestGain = gain;
+            nodes[top.id].producer = recipeId;
+            nodes[top.id].yield = top.yield;
+            nodes[top.id].inputs = std::move(top.inputs);
+        }
+        top.producer++;
+        top.yield = 0;
+    }
+    return result;
+}
+
+// Order
+// Lists the target and everything its chosen producers need in reverse
+// post-order, skipping edges back into the current path
+void craftabilitysolver::Order(int target, scratch& work) const {
+    vector<int> postOrder;
+    vector<pair<int, size_t>> path;
+    work.position[target] = -2;
+    path.push_back({target, 0});
+    while (!path.empty()) {
+        int current = path.back().first;
+        size_t& next = path.back().second;
+        if (next < nodes[current].inputs.size()) {
+            int input = nodes[current].inputs[next++].first;
+            if (work.position[input] == -1) {
+                work.position[input] = -2;
+                path.push_back({input, 0});
+            }
+        }
+        else {
+            postOrder.push_back(current);
+            path.pop_back();
+        }
+    }
+
+    work.order.assign(postOrder.rbegin(), postOrder.rend());
+    for (size_t i = 0; i < work.order.size(); i++) {
+        work.position[work.order[i]] = (int) i;
+    }
+}
+
+// Feasible
+// Explodes the demand for a quantity of work.order[0] through the chosen
+// producers and checks that no material runs out
+bool craftabilitysolver::Feasible(long long quantity, scratch& work) const {
+    for (int id : work.order) {
+        work.demand[id] = 0;
+        work.stockLeft[id] = nodes[id].stock;
+    }
+    work.demand[work.order[0]] = (double) quantity;
+
+    for (size_t i = 0; i < work.order.size(); i++) {
+        const node& current = nodes[work.order[i]];
+        double needed = work.demand[work.order[i]];
+        double used = min(work.stockLeft[work.order[i]], needed);
+        work.stockLeft[work.order[i]] -= used;
+        double shortfall = needed - used;
+        if (shortfall <= EPSILON) {
+            continue;
+        }
+        if (current.producer < 0) {
+            return false;
+        }
+
+        double crafts = ceil(shortfall / current.yield - EPSILON);
+        for (const pair<int, int>& input : current.inputs) {
+            double inputNeeded = crafts * input.second;
+            if (work.position[input.first] > (int) i) {
+                work.demand[input.first] += inputNeeded;
+            }
+            else if (work.stockLeft[input.first] + EPSILON >= inputNeeded) {
+                work.stockLeft[input.first] -= inputNeeded;
+            }
+            else {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Max Producible
+// Binary searches the largest feasible quantity below the target's bound
+long long craftabilitysolver::MaxProducible(int target, scratch& work) const {
+    Order(target, work);
+    long long low = 0;
+    long long high = (long long) floor(nodes[target].bound + EPSILON);
+    while (low < high) {
+        long long middle = low + (high - low + 1) / 2;
+        if (Feasible(middle, work)) {
+            low = middle;
+        }
+        else {
+            high = middle - 1;
+        }
+    }
+
+    for (int id : work.order) {
+        work.position[id] = -1;
+    }
+    return low;
+}
+
+// Query Max Producible
+long long craftabilitysolver::QueryMaxProducible(const string& material,
+                                                 const stockpile& resources) {
+    return QueryMaxProducible(vector<string>{material}, resources, 1)[0];
+}
+
+// Query Max Producible
+// Builds the memo for every target first, then searches in parallel
+vector<long long> craftabilitysolver::QueryMaxProducible(
+        const vector<string>& materials, const stockpile& resources,
+        int threadCount) {
+    Prepare(resources);
+    vector<int> targets;
+    targets.reserve(materials.size());
+    for (const string& material : materials) {
+        targets.push_back(Solve(material));
+    }
+
+    if (threadCount <= 0) {
+        threadCount = max(1, (int) thread::hardware_concurrency());
+    }
+    threadCount = max(1, min(threadCount, (int) targets.size()));
+
+    vector<long long> result(targets.size());
+    auto work = [this, &targets, &result](size_t first, size_t last) {
+        scratch local;
+        local.position.assign(nodes.size(), -1);
+        local.demand.assign(nodes.size(), 0);
+        local.stockLeft.assign(nodes.size(), 0);
+        for (size_t t = first; t < last; t++) {
+            result[t] = MaxProducible(targets[t], local);
+        }
+    };
+
+    size_t chunk = (targets.size() + threadCount - 1) / threadCount;
+    vector<thread> workers;
+    for (int w = 1; w < threadCount; w++) {
+        size_t first = min(targets.size(), w * chunk);
+        size_t last = min(targets.size(), first + chunk);
+        if (first < last) {
+            workers.emplace_back(work, first, last);
+        }
+    }
+    work(0, min(targets.size(), chunk));
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    return result;
+}
@@ -0,0 +1,113 @@
+// AUTHOR:      Hongru He
+// FILENAME:    craftabilitysolver.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_CRAFTABILITYSOLVER_H
+#define P4_CRAFTABILITYSOLVER_H
+#include "recipecatalog.h"
+#include "stockpile.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// How much one craft of a recipe is assumed to yield.
+// Nominal:     the recipe's output numbers, as on a normal outcome.
+// Expected:    the output numbers times the recipe's expected multiplier.
+// Pessimistic: the output numbers times the lowest multiplier of an outcome
+//              that produces anything (a partial outcome).
+enum class yieldmode : unsigned char {
+    Nominal,
+    Expected,
+    Pessimistic
+};
+
+// The CraftabilitySolver class computes how much of a material can be
+// obtained from a Stockpile, crafting intermediates through recipe chains of
+// any depth. Every material is made by a single recipe, so the result is a
+// single-route bound: splitting the demand for a material across several of
+// its recipes may obtain more, and is not considered.
+// Class Invariants:
+// 1.   Every material has at most one chosen producer: the recipe with the
+//      largest optimistic bound, found by memoized dynamic programming over
+//      the recipe graph.
+// 2.   An answer is always achievable with the chosen producers: it is the
+//      largest quantity for which exploding the demand through the recipe
+//      chain never runs out of stock.
+// 3.   Recipe cycles are cut where they close, so a material is never
+//      needed to produce itself.
+
+class craftabilitysolver {
+private:
+    struct node {
+        double stock = 0;
+        double bound = 0;
+        double yield = 0;
+        int producer = -1;
+        int state = 0;
+        vector<pair<int, int>> inputs;
+    };
+
+    struct scratch {
+        vector<int> order;
+        vector<int> position;
+        vector<double> demand;
+        vector<double> stockLeft;
+    };
+
+    const recipecatalog* catalog;
+    yieldmode mode;
+    vector<node> nodes;
+    unordered_map<string, int> nodeIds;
+    unordered_map<string, double> quantities;
+
+    int Solve(const string&);
+    // Get the node of a material, computing its bound and producer first
+
+    void Order(int, scratch&) const;
+    // List the materials a target depends on, consumers before producers
+
+    bool Feasible(long long, scratch&) const;
+    // Check if a quantity of the ordered target can be obtained
+
+    long long MaxProducible(int, scratch&) const;
+    // Binary search the largest feasible quantity of a target
+
+    void Prepare(const stockpile&);
+    // Clear the memo and read the quantities of the Stockpile
+
+public:
+    explicit craftabilitysolver(const recipecatalog&,
+                                yieldmode = yieldmode::Nominal);
+    // Overloaded Constructor
+    // Explanation:     Initializes a CraftabilitySolver over a catalog.
+    // Precondition:    The catalog outlives the solver and is not modified
+    //                  during a query.
+    // Postcondition:   CraftabilitySolver object is ready for queries.
+
+    long long QueryMaxProducible(const string&, const stockpile&);
+    // Get the largest obtainable quantity of a material
+    // Explanation:     Counts the material in the Stockpile plus what can
+    //                  be crafted from the rest, through any depth, using
+    //                  the chosen producer of every material.
+    // Precondition:    None.
+    // Postcondition:   Return the quantity, rounded down.
+
+    vector<long long> QueryMaxProducible(const vector<string>&,
+                                         const stockpile&, int = 0);
+    // Get the largest obtainable quantity of many materials
+    // Explanation:     Shares one memo for all targets and searches the
+    //                  targets on the given number of threads; 0 uses every
+    //                  hardware thread.
+    // Precondition:    The Stockpile is not modified during the query.
+    // Postcondition:   Return one quantity per target, each computed as if
+    //                  it were the only target.
+
+    static double QueryYield(const formula&, yieldmode);
+    // Get the multiplier of a recipe's outputs under a yield mode
+};
+
+
+#endif //P4_CRAFTABILITYSOLVER_H
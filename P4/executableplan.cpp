@@ -5,10 +5,19 @@
 
 #include "executableplan.h"
 #include "stockpile.h"
+#include "outcomerecorder.h"
+#include "plandag.h"
+#include <condition_variable>
+#include <exception>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <queue>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
 
@@ -21,16 +30,33 @@ using namespace std;
 // 3.   The class must ensure that any dependencies between actions are
 //      resolved before execution, guaranteeing that the plan is viable at
 //      any point.
+// 4.   Completion of steps is derived from currentStep alone; Formulas keep
+//      no completed flag, so Reset only rewinds the cursor and runs in O(1)
+//      for plans executed in a loop. generation only counts resets and
+//      cycles for the Journal.
+// 5.   ApplyParallel never touches the Stockpile while steps run. Steps
+//      that add to the same material may run together, so outputs are kept
+//      per step; before a step checks its inputs, the outputs of the
+//      earlier steps are added to a private copy of each input in step
+//      order, so it sees the same quantity as in a sequential run. The
+//      outputs are then committed in step order. Joins of the PlanDAG
+//      never run; a join that finishes releases its steps at once.
 
 // Default Constructor
 executableplan::executableplan() : plan() {
     currentStep = 0;
+    generation = 0;
+    cyclic = false;
+    collectStatistics = false;
 }
 
 // Overloaded Constructor
 executableplan::executableplan(formula * formulaList, int inputNum) :
 plan(formulaList, inputNum) {
     currentStep = 0;
+    generation = 0;
+    cyclic = false;
+    collectStatistics = false;
 }
 
 // Destructor
@@ -41,13 +67,24 @@ executableplan::~executableplan() {
 // Copy Constructor
 executableplan::executableplan(const executableplan& other) : plan(other) {
     currentStep = other.currentStep;
+    generation = other.generation;
+    cyclic = other.cyclic;
+    collectStatistics = other.collectStatistics;
+    statistics = other.statistics;
 }
 
 // Move Constructor
 executableplan::executableplan(executableplan&& other) noexcept :
 plan(std::move(other)) {
     currentStep = other.currentStep;
+    generation = other.generation;
+    cyclic = other.cyclic;
+    collectStatistics = other.collectStatistics;
+    statistics = other.statistics;
+    eventLog = std::move(other.eventLog);
     other.currentStep = 0;
+    other.generation = 0;
+    other.statistics = cyclestatistics();
 }
 
 // Overloaded Assignment Operator
@@ -55,6 +92,10 @@ executableplan& executableplan::operator=(const executableplan& other) {
     if (this != &other) {
         plan::operator=(other);
         currentStep = other.currentStep;
+        generation = other.generation;
+        cyclic = other.cyclic;
+        collectStatistics = other.collectStatistics;
+        statistics = other.statistics;
     }
     return *this;
 }
@@ -64,14 +105,21 @@ executableplan& executableplan::operator=(executableplan&& other) noexcept {
     if (this != &other) {
         plan::operator=(std::move(other));
         currentStep = other.currentStep;
+        generation = other.generation;
+        cyclic = other.cyclic;
+        collectStatistics = other.collectStatistics;
+        statistics = other.statistics;
+        eventLog = std::move(other.eventLog);
         other.currentStep = 0;
+        other.generation = 0;
+        other.statistics = cyclestatistics();
     }
 
     return *this;
 }
 
 // Overloaded Comparison Operator
-bool executableplan::operator==(const executableplan& other) {
+bool executableplan::operator==(const executableplan& other) const {
     if (plan::operator==(other)) {
         return currentStep == other.currentStep;
     }
@@ -79,7 +127,7 @@ bool executableplan::operator==(const executableplan& other) {
 }
 
 // Overloaded Comparison Operator
-bool executableplan::operator!=(const executableplan& other) {
+bool executableplan::operator!=(const executableplan& other) const {
     if (currentStep != other.currentStep) {
         return true;
     }
@@ -125,6 +173,11 @@ string executableplan::QueryCurrentStep() {
     return result.str();
 }
 
+// Get the index of the current step
+int executableplan::QueryCurrentIndex() const {
+    return currentStep;
+}
+
 // Apply the current step's formula
 string executableplan::ApplyCurrentStep() {
     if (currentStep >= size) {
@@ -134,13 +187,13 @@ string executableplan::ApplyCurrentStep() {
 
     string result = planList[currentStep].Apply();
 
-    currentStep++;
+    AdvanceStep(result);
     return result;
 }
 
 // Extract output quantities from the result string of Formula's Apply function
 double* executableplan::ExtractOutputNumber(const string& resultStr, int size) {
-    double* outputResult = new double[size];
+    double* outputResult = new double[size]();
     stringstream extractLine(resultStr);
     string resultLine;
     int i = 0;
@@ -165,7 +218,7 @@ shared_ptr<stockpile> executableplan::Apply(shared_ptr<stockpile> inputPtr) {
     bool resourcesAvailable = true;
     formula& currentFormula = planList[currentStep];
 
-    for (int i = 0; i < this->size; ++i) {
+    for (int i = 0; i < currentFormula.QueryInputSize(); ++i) {
         string resourceName = currentFormula.QueryInputMaterial(i);
         int requiredQuantity = currentFormula.QueryInputNumber(i);
         if (!inputPtr->CheckMaterial(resourceName, requiredQuantity)) {
@@ -190,23 +243,326 @@ shared_ptr<stockpile> executableplan::Apply(shared_ptr<stockpile> inputPtr) {
     for (int k = 0; k < resultSize; k++) {
         inputPtr->IncreaseResource(outputMaterial[k], outputNumber[k]);
     }
+    delete[] outputNumber;
+    delete[] outputMaterial;
 
-    currentStep++;
+    AdvanceStep(result);
 
     return inputPtr;
 }
 
-// Reset all formulas
-void executableplan::Reset() {
+// Apply every remaining step, running independent steps concurrently
+// A step that runs before an earlier step has succeeded keeps a copy of its
+// Formula, so it can be undone if that earlier step fails.
+shared_ptr<stockpile> executableplan::ApplyParallel(
+        shared_ptr<stockpile> inputPtr, int threads) {
     if (currentStep >= size) {
-        for (int i = 0; i < size; i++) {
-            planList[i].ResetCompleted();
+        throw runtime_error("No more formulas to apply.");
+    }
+
+    enum stepstate { Pending, Applied, Short, Failed, Rejected };
+    int first = currentStep;
+    int last = size;
+    int count = last - first;
+    plandag dag(*this);
+
+    // The quantities the remaining steps touch, copied once, and the
+    // outputs that add to each of them in step order
+    unordered_map<string, int> materialIds;
+    vector<double> quantity;
+    vector<char> present;
+    vector<char> original;
+    vector<vector<pair<int, int>>> writes;
+    vector<size_t> settled;
+    auto intern = [&](const string& name) {
+        auto item = materialIds.emplace(name, (int) quantity.size());
+        if (item.second) {
+            quantity.push_back(0);
+            present.push_back(0);
+            writes.emplace_back();
+        }
+        return item.first->second;
+    };
+    vector<vector<pair<int, int>>> inputs(count);
+    vector<vector<int>> outputs(count);
+    for (int k = 0; k < count; k++) {
+        const formula& step = planList[first + k];
+        for (int i = 0; i < step.QueryInputSize(); i++) {
+            inputs[k].push_back({intern(step.QueryInputMaterial(i)),
+                                 step.QueryInputNumber(i)});
+        }
+        for (int j = 0; j < step.QueryOutputSize(); j++) {
+            outputs[k].push_back(intern(step.QueryOutputMaterial(j)));
+            writes[outputs[k].back()].push_back({k, j});
+        }
+    }
+    inputPtr->ForEachResource([&](const string& name, double amount) {
+        auto item = materialIds.find(name);
+        if (item != materialIds.end()) {
+            quantity[item->second] = amount;
+            present[item->second] = 1;
+        }
+    });
+    original = present;
+    settled.assign(quantity.size(), 0);
+    bool frozen = inputPtr->QueryFrozen();
+
+    // Completed steps are done, and so is a join once its steps are
+    vector<int> waiting(dag.QueryNodeCount(), 0);
+    priority_queue<int, vector<int>, greater<int>> ready;
+    for (int node : dag.QueryOrder()) {
+        if (node < first) {
+            continue;
+        }
+        for (int predecessor : dag.QueryPredecessors(node)) {
+            bool done = predecessor < first ||
+                        (dag.QueryJoin(predecessor) &&
+                         waiting[predecessor] == 0);
+            waiting[node] += done ? 0 : 1;
+        }
+        if (waiting[node] == 0 && !dag.QueryJoin(node)) {
+            ready.push(node);
+        }
+    }
+    // Releases the successors of a finished step, passing through joins
+    auto release = [&](int step) {
+        for (int successor : dag.QuerySuccessors(step)) {
+            if (--waiting[successor] > 0) {
+                continue;
+            }
+            if (!dag.QueryJoin(successor)) {
+                ready.push(successor);
+                continue;
+            }
+            for (int next : dag.QuerySuccessors(successor)) {
+                if (--waiting[next] == 0) {
+                    ready.push(next);
+                }
+            }
+        }
+    };
+
+    vector<char> state(count, Pending);
+    vector<vector<double>> produced(count);
+    vector<string> results(count);
+    vector<exception_ptr> errors(count);
+    vector<unique_ptr<formula>> snapshots(count);
+
+    // Checks the inputs of a step, under the lock. The PlanDAG makes every
+    // earlier step that adds to an input finish first.
+    auto check = [&](int step) {
+        int k = step - first;
+        for (const pair<int, int>& input : inputs[k]) {
+            int material = input.first;
+            vector<pair<int, int>>& added = writes[material];
+            for (; settled[material] < added.size() &&
+                   added[settled[material]].first < k; settled[material]++) {
+                const pair<int, int>& output = added[settled[material]];
+                quantity[material] += produced[output.first][output.second];
+                present[material] = 1;
+            }
+            if (!present[material] || quantity[material] < input.second) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Applies a step and keeps its outputs
+    auto run = [&](int step) {
+        int k = step - first;
+        try {
+            results[k] = planList[step].Apply();
+        }
+        catch (...) {
+            errors[k] = current_exception();
+            return Failed;
+        }
+        int outputSize = (int) outputs[k].size();
+        double* outputNumber = ExtractOutputNumber(results[k], outputSize);
+        produced[k].assign(outputNumber, outputNumber + outputSize);
+        delete[] outputNumber;
+        for (int material : outputs[k]) {
+            if (frozen && !original[material]) {
+                return Rejected;
+            }
+        }
+        return Applied;
+    };
+
+    mutex lock;
+    condition_variable wake;
+    int running = 0;
+    int stop = last;
+    int frontier = first;
+    auto worker = [&]() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [&]() { return !ready.empty() || running == 0; });
+            if (ready.empty()) {
+                return;
+            }
+            int step = ready.top();
+            ready.pop();
+            if (step > stop) {
+                continue;
+            }
+            if (!check(step)) {
+                state[step - first] = Short;
+                stop = min(stop, step);
+                wake.notify_all();
+                continue;
+            }
+            running++;
+            bool speculative = step != frontier;
+            guard.unlock();
+
+            int k = step - first;
+            if (speculative) {
+                snapshots[k].reset(new formula(planList[step]));
+            }
+            int outcome = run(step);
+
+            guard.lock();
+            running--;
+            state[k] = (char) outcome;
+            if (outcome == Applied) {
+                release(step);
+                while (frontier < last && state[frontier - first] == Applied) {
+                    snapshots[frontier - first].reset();
+                    frontier++;
+                }
+            }
+            else {
+                stop = min(stop, step);
+            }
+            wake.notify_all();
+        }
+    };
+
+    if (threads <= 0) {
+        threads = (int) thread::hardware_concurrency();
+    }
+    threads = max(1, min(threads, count));
+    vector<thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (thread& t : pool) {
+        t.join();
+    }
+
+    // Undo the steps that ran past the first failure, then commit in order
+    for (int step = stop + 1; step < last; step++) {
+        if (snapshots[step - first]) {
+            planList[step] = std::move(*snapshots[step - first]);
+        }
+    }
+    for (int step = first; step < stop; step++) {
+        int k = step - first;
+        for (size_t j = 0; j < outputs[k].size(); j++) {
+            inputPtr->IncreaseResource(planList[step].QueryOutputMaterial(j),
+                                       produced[k][j]);
+        }
+        AdvanceStep(results[k]);
+    }
+    if (stop < last) {
+        int k = stop - first;
+        if (state[k] == Short) {
+            throw runtime_error("Insufficient resources to apply formula.");
+        }
+        if (state[k] == Failed) {
+            rethrow_exception(errors[k]);
+        }
+        for (size_t j = 0; j < outputs[k].size(); j++) {
+            inputPtr->IncreaseResource(planList[stop].QueryOutputMaterial(j),
+                                       produced[k][j]);
+        }
+    }
+
+    return inputPtr;
+}
+
+// Move the cursor past the applied step
+void executableplan::AdvanceStep(const string& result) {
+    currentStep++;
+
+    if (collectStatistics) {
+        statistics.stepsApplied++;
+        if (result == "There is nothing produced.") {
+            statistics.failedSteps++;
+            statistics.totalFailedSteps++;
         }
+    }
+
+    if (cyclic && currentStep >= size) {
+        currentStep = 0;
+        generation++;
+        if (collectStatistics) {
+            statistics.cycles++;
+            statistics.lastCycleFailedSteps = statistics.failedSteps;
+            statistics.stepsApplied = 0;
+            statistics.failedSteps = 0;
+        }
+    }
+
+    if (eventLog) {
+        eventLog->RecordApply(currentStep, generation);
+    }
+}
+
+// Reset all formulas
+// Rewinding the cursor marks every step as uncompleted at once.
+void executableplan::Reset() {
+    currentStep = 0;
+    generation++;
+    if (collectStatistics) {
+        statistics.stepsApplied = 0;
+        statistics.failedSteps = 0;
+    }
+    if (eventLog) {
+        eventLog->RecordReset(currentStep, generation);
+    }
+}
 
+// Check if the step at a specific index is below the current step
+bool executableplan::QueryStepCompleted(int index) const {
+    return index >= 0 && index < currentStep;
+}
+
+// Get the number of resets and completed cycles so far
+unsigned long executableplan::QueryGeneration() const {
+    return generation;
+}
+
+// Turn the cyclic mode on or off
+void executableplan::SetCyclic(bool isCyclic) {
+    cyclic = isCyclic;
+    if (cyclic && size > 0 && currentStep >= size) {
         currentStep = 0;
+        generation++;
+    }
+}
+
+// Check if the plan runs in cyclic mode
+bool executableplan::QueryCyclic() const {
+    return cyclic;
+}
+
+// Turn the collection of per-cycle statistics on or off
+void executableplan::EnableCycleStatistics(bool enable) {
+    collectStatistics = enable;
+    if (!enable) {
+        statistics = cyclestatistics();
     }
 }
 
+// Get the per-cycle statistics collected so far
+cyclestatistics executableplan::QueryCycleStatistics() const {
+    return statistics;
+}
+
 // Replace the formula in a specific index
 void executableplan::Replace(formula && newFor, int index) {
     if (index < currentStep) {
@@ -218,9 +574,29 @@ void executableplan::Replace(formula && newFor, int index) {
 
 // Remove the last formula from the plan list
 void executableplan::Remove() {
-    if (planList[size - 1].QueryCompleted()) {
+    if (QueryStepCompleted(size - 1)) {
         throw std::out_of_range("Cannot remove the completed formula.");
     }
 
     plan::Remove();
-}
\ No newline at end of file
+}
+
+// Seed every formula for a reproducible run
+// Step i gets the seed plus i, so equal recipes still roll apart.
+void executableplan::Seed(unsigned int seed) {
+    for (int i = 0; i < size; i++) {
+        planList[i].Seed(seed + (unsigned int) i);
+    }
+}
+
+// Record every applied step and reset in a Journal
+void executableplan::AttachJournal(shared_ptr<journal> log) {
+    eventLog = std::move(log);
+}
+
+// Record or replay the outcome tiers of the formulas in the plan
+void executableplan::AttachRecorder(shared_ptr<outcomerecorder> recorder) {
+    for (int i = 0; i < size; i++) {
+        planList[i].AttachRecorder(recorder);
+    }
+}
@@ -6,6 +6,7 @@
 #ifndef P4_EXECUTABLEPLAN_H
 #define P4_EXECUTABLEPLAN_H
 #include "plan.h"
+#include "journal.h"
 #include "stockpile.h"
 #include <memory>
 
@@ -18,13 +19,34 @@ using namespace std;
 //      depend on the completion of previous actions.
 // 2.   The object ensures that actions are executable in the sequence they
 //      are added unless explicitly modified.
+// 3.   A step is completed if and only if its index is below the current
+//      step, so a reset only rewinds the cursor. The generation counts the
+//      resets and cycles and does not decide completion.
+
+// Statistics of an executable plan running in cyclic mode.
+struct cyclestatistics {
+    unsigned long cycles = 0;       // Number of completed cycles
+    int stepsApplied = 0;           // Steps applied in the running cycle
+    int failedSteps = 0;            // Failed steps in the running cycle
+    int lastCycleFailedSteps = 0;   // Failed steps in the last full cycle
+    unsigned long totalFailedSteps = 0;
+};
 
 class executableplan : public plan {
 private:
     int currentStep;
+    unsigned long generation;
+    bool cyclic;
+    bool collectStatistics;
+    cyclestatistics statistics;
+    shared_ptr<journal> eventLog;
 
     double* ExtractOutputNumber(const string&, int);
 
+    void AdvanceStep(const string&);
+    // Move the cursor past the step that has just been applied, wrapping
+    // around and starting a new generation in cyclic mode
+
 public:
     executableplan();
     // Default Constructor
@@ -47,10 +69,10 @@ public:
     executableplan& operator=(executableplan&&) noexcept;
     // Move Assignment Operator
 
-    bool operator==(const executableplan&);
+    bool operator==(const executableplan&) const;
     // Overloaded Relational Operator
 
-    bool operator!=(const executableplan&);
+    bool operator!=(const executableplan&) const;
     // Overloaded Relational Operator
 
     executableplan& operator+(executableplan&);
@@ -65,14 +87,56 @@ public:
     string QueryCurrentStep();
     // Get the current step
 
+    int QueryCurrentIndex() const;
+    // Get the index of the current step
+
     string ApplyCurrentStep();
     // Apply the current step's formula
 
     shared_ptr<stockpile> Apply(shared_ptr<stockpile>);
     // Overloaded apply taking the smart pointer of a stockpile
 
+    shared_ptr<stockpile> ApplyParallel(shared_ptr<stockpile>, int = 0);
+    // Apply every remaining step, running independent steps concurrently
+    // Explanation:     Steps run on a pool of threads as soon as the steps
+    //                  they depend on are done. The Stockpile sees the same
+    //                  increases in the same order as with Apply, so the
+    //                  result is identical under the same seeds.
+    // Precondition:    No Formula shares a recorder and no watcher of the
+    //                  Stockpile modifies it.
+    // Postcondition:   Like calling Apply until the last step; a step short
+    //                  of inputs throws a runtime_error after every earlier
+    //                  step was applied, and no later one.
+
+    void Seed(unsigned int);
+    // Seed every formula for a reproducible run
+
     void Reset();
-    // Reset current step and all the formulas' states
+    // Reset current step and start a new generation in constant time
+
+    bool QueryStepCompleted(int) const;
+    // Check if the step at a specific index is below the current step
+
+    unsigned long QueryGeneration() const;
+    // Get the number of resets and completed cycles so far
+
+    void SetCyclic(bool);
+    // Wrap the current step back to the first formula after the last one
+
+    bool QueryCyclic() const;
+    // Check if the plan runs in cyclic mode
+
+    void EnableCycleStatistics(bool);
+    // Turn the collection of per-cycle statistics on or off
+
+    cyclestatistics QueryCycleStatistics() const;
+    // Get the per-cycle statistics collected so far
+
+    void AttachJournal(shared_ptr<journal>);
+    // Record every applied step and reset in a Journal
+
+    void AttachRecorder(shared_ptr<outcomerecorder>);
+    // Record or replay the outcome tiers of the formulas in the plan
 
     void Replace(formula&&, int) override;
     // Replace a formula at a specific index
@@ -0,0 +1,161 @@
+// AUTHOR:      Hongru He
+// FILENAME:    fixedstockpile.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_FIXEDSTOCKPILE_H
+#define P4_FIXEDSTOCKPILE_H
+#include <array>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+// The FixedStockpile and FixedFormula class templates specialize Stockpile
+// and Formula for a small set of materials known at compile time. Materials
+// are the enumerators of an enum class whose last enumerator is Count.
+// Class Invariants:
+// 1.   The quantity of material m is quantities[m]; there is no hashing and
+//      no allocation.
+// 2.   A FixedFormula's recipe never changes after construction, so recipes
+//      can be constexpr tables in read-only data.
+// 3.   Tier odds and proficiency follow the same rules as Formula.
+
+template <typename Material, size_t N = (size_t) Material::Count>
+class fixedstockpile {
+private:
+    array<double, N> quantities{};
+
+public:
+    // Default Constructor
+    // Explanation:     Initializes every quantity to 0.
+    constexpr fixedstockpile() = default;
+
+    // Get the quantity of the specific material
+    constexpr double QueryQuantity(Material material) const {
+        return quantities[(size_t) material];
+    }
+
+    // Increase the quantity of the specific material
+    constexpr void IncreaseResource(Material material, double numAdd) {
+        quantities[(size_t) material] += numAdd;
+    }
+
+    // Decrease the quantity of the specific material if it is sufficient
+    constexpr bool DecreaseResource(Material material, int numDec) {
+        if (quantities[(size_t) material] >= numDec) {
+            quantities[(size_t) material] -= numDec;
+            return true;
+        }
+        return false;
+    }
+
+    // Check if the quantity of the specific material is sufficient
+    constexpr bool CheckMaterial(Material material, int number) const {
+        return quantities[(size_t) material] >= number;
+    }
+};
+
+// One material of a FixedFormula's recipe with its number.
+template <typename Material>
+struct fixedingredient {
+    Material material;
+    int number;
+};
+
+template <typename Material, size_t In, size_t Out>
+class fixedformula {
+private:
+    array<fixedingredient<Material>, In> inputs;
+    array<fixedingredient<Material>, Out> outputs;
+    int failure = 30;
+    int partial = 25;
+    int normal = 42;
+    int bonus = 3;
+    int proficiencyLevel = 0;
+    int experienceNum = 0;
+    static constexpr int MAXEXP = 6;
+    static constexpr int MAXPRO = 2;
+
+    constexpr void IncreaseExp() {
+        if (experienceNum < MAXEXP) {
+            experienceNum++;
+            if (experienceNum == MAXEXP) {
+                IncreaseLevel();
+            }
+        }
+    }
+
+    constexpr void IncreaseLevel() {
+        if (proficiencyLevel < MAXPRO) {
+            proficiencyLevel++;
+            failure -= 5;
+            partial -= 5;
+            normal += 8;
+            bonus += 2;
+        }
+    }
+
+public:
+    // Overloaded Constructor
+    // Explanation:     Initializes a FixedFormula with its recipe.
+    constexpr fixedformula(const array<fixedingredient<Material>, In>& in,
+                           const array<fixedingredient<Material>, Out>& out)
+            : inputs(in), outputs(out) {}
+
+    // Check if a FixedStockpile holds every input of the recipe
+    template <size_t N>
+    constexpr bool CheckMaterial(
+            const fixedstockpile<Material, N>& stock) const {
+        for (size_t i = 0; i < In; i++) {
+            if (!stock.CheckMaterial(inputs[i].material, inputs[i].number)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Get the outcome tier of a roll between 0 and 100
+    constexpr int QueryTier(int randomNum) const {
+        if (randomNum <= failure) {
+            return 0;
+        }
+        if (randomNum <= failure + partial) {
+            return 1;
+        }
+        if (randomNum <= failure + partial + normal) {
+            return 2;
+        }
+        return 3;
+    }
+
+    // Apply the recipe to a FixedStockpile
+    // Explanation:     Checks the inputs, rolls the outcome tier like
+    //                  Formula's Apply and adds the outputs for that tier.
+    // Precondition:    The FixedStockpile holds every input; otherwise a
+    //                  runtime_error is thrown.
+    // Postcondition:   Return the outcome tier from 0 for failure to 3 for
+    //                  bonus.
+    template <size_t N, typename Generator>
+    int Apply(fixedstockpile<Material, N>& stock, Generator& gen) {
+        if (!CheckMaterial(stock)) {
+            throw runtime_error("Insufficient resources to apply formula.");
+        }
+
+        uniform_int_distribution<> dis{0, 100};
+        int tier = QueryTier(dis(gen));
+        constexpr double multiplier[4] = {0, 0.75, 1, 1.1};
+        if (tier > 0) {
+            for (size_t i = 0; i < Out; i++) {
+                stock.IncreaseResource(outputs[i].material,
+                                       outputs[i].number * multiplier[tier]);
+            }
+            IncreaseExp();
+        }
+        return tier;
+    }
+};
+
+
+#endif //P4_FIXEDSTOCKPILE_H
@@ -4,9 +4,24 @@
 // VERSION:     V1.0
 
 #include "formula.h"
+#include "outcomerecorder.h"
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 using namespace std;
+
+// The steps of a fused Formula, run as one. Each outcome is one combination
+// of the steps' tiers, ending at the first failure, with its probability
+// and the product of the steps' multipliers.
+struct formula::fusion {
+    vector<formula> steps;
+    vector<vector<int>> outcomeTiers;
+    vector<double> outcomeMultipliers;
+    vector<double> cumulative;
+    vector<int> lastTiers;
+    uniform_real_distribution<double> draw{0, 1};
+};
 // Default Constructor
 formula::formula() {
     inputMaterial = nullptr;
@@ -22,7 +37,7 @@ formula::formula() {
     bonus = 0;
     proficiencyLevel = 0;
     experienceNum = 0;
-    completed = false;
+    recipeHash = HashRecipe();
 }
 
 // Overloaded Constructor
@@ -43,7 +58,7 @@ formula::formula(string* inputM, int* inputN, int input, string* outputM,
     partial = 25;
     normal = 42;
     bonus = 3;
-    completed = false;
+    recipeHash = HashRecipe();
 }
 
 // Deconstructor
@@ -60,26 +75,44 @@ formula::~formula() {
     bonus = 0;
     proficiencyLevel = 0;
     experienceNum = 0;
-    completed = false;
 }
 
 // Copy Constructor
 formula::formula(const formula& other) {
-    inputMaterial = other.inputMaterial;
-    inputNumber = other.inputNumber;
-    outputMaterial = other.outputMaterial;
-    outputNumber = other.outputNumber;
-
     inputSize = other.inputSize;
     outputSize = other.outputSize;
 
+    inputMaterial = new string[inputSize];
+    inputNumber = new int[inputSize];
+
+    for (int i = 0; i < inputSize; i++) {
+        inputMaterial[i] = other.inputMaterial[i];
+        inputNumber[i] = other.inputNumber[i];
+    }
+
+    outputMaterial = new string[outputSize];
+    outputNumber = new int[outputSize];
+
+    for (int j = 0; j < outputSize; j++) {
+        outputMaterial[j] = other.outputMaterial[j];
+        outputNumber[j] = other.outputNumber[j];
+    }
+
     proficiencyLevel = other.proficiencyLevel;
     experienceNum = other.experienceNum;
     failure = other.failure;
     partial = other.partial;
     normal = other.normal;
     bonus = other.bonus;
-    completed = other.completed;
+    recorder = other.recorder;
+    recipeHash = other.recipeHash;
+    seeded = other.seeded;
+    if (seeded) {
+        gen.reset(new mt19937(*other.gen));
+    }
+    if (other.fused) {
+        fused.reset(new fusion(*other.fused));
+    }
 }
 
 // Overloaded Assignment Operator
@@ -115,7 +148,13 @@ formula& formula::operator=(const formula& other) {
         partial = other.partial;
         normal = other.normal;
         bonus = other.bonus;
-        completed = other.completed;
+        recorder = other.recorder;
+        recipeHash = other.recipeHash;
+        seeded = other.seeded;
+        if (seeded) {
+            gen.reset(new mt19937(*other.gen));
+        }
+        fused.reset(other.fused ? new fusion(*other.fused) : nullptr);
     }
 
     return *this;
@@ -123,7 +162,11 @@ formula& formula::operator=(const formula& other) {
 
 // Overloaded Relational Operator
 bool formula::operator==(const formula& other) const {
-    if (completed != other.completed)
+    // Different recipes almost always differ in their hashes, so most
+    // unequal Formulas are rejected without comparing any material.
+    if (recipeHash != other.recipeHash)
+        return false;
+    if ((fused == nullptr) != (other.fused == nullptr))
         return false;
     if (inputSize != other.inputSize || outputSize != other.outputSize)
         return false;
@@ -164,7 +207,11 @@ formula::formula(formula&& other) noexcept {
     partial = other.partial;
     normal = other.normal;
     bonus = other.bonus;
-    completed = other.completed;
+    recorder = std::move(other.recorder);
+    recipeHash = other.recipeHash;
+    seeded = other.seeded;
+    gen = std::move(other.gen);
+    fused = std::move(other.fused);
 
     other.inputMaterial = nullptr;
     other.inputNumber = nullptr;
@@ -172,6 +219,8 @@ formula::formula(formula&& other) noexcept {
     other.outputNumber = nullptr;
     other.inputSize = 0;
     other.outputSize = 0;
+    other.recipeHash = other.HashRecipe();
+    other.seeded = false;
 }
 
 // Move Assignment Operator
@@ -196,7 +245,11 @@ formula& formula::operator=(formula&& other) noexcept {
         partial = other.partial;
         normal = other.normal;
         bonus = other.bonus;
-        completed = other.completed;
+        recorder = std::move(other.recorder);
+        recipeHash = other.recipeHash;
+        seeded = other.seeded;
+        gen = std::move(other.gen);
+        fused = std::move(other.fused);
 
         other.inputMaterial = nullptr;
         other.inputNumber = nullptr;
@@ -204,6 +257,8 @@ formula& formula::operator=(formula&& other) noexcept {
         other.outputMaterial = nullptr;
         other.outputNumber = nullptr;
         other.outputSize = 0;
+        other.recipeHash = other.HashRecipe();
+        other.seeded = false;
     }
 
     return *this;
@@ -247,18 +302,22 @@ string formula::QueryOutput() {
     return outputResult.str();
 }
 
-string formula::QueryInputMaterial(int index) const {
+// The material getters return a reference, so lookups do not copy the
+// name; an index out of range gets a reference to an empty name.
+const string& formula::QueryInputMaterial(int index) const {
+    static const string noMaterial;
     if (index >= 0 && index < inputSize) {
         return inputMaterial[index];
     }
-    return "";
+    return noMaterial;
 }
 
-string formula::QueryOutputMaterial(int index) const {
+const string& formula::QueryOutputMaterial(int index) const {
+    static const string noMaterial;
     if (index >= 0 && index < outputSize) {
         return outputMaterial[index];
     }
-    return "";
+    return noMaterial;
 }
 
 int formula::QueryInputNumber(int index) const {
@@ -268,48 +327,96 @@ int formula::QueryInputNumber(int index) const {
     return -1;
 }
 
-int formula::QueryInputSize() {
+int formula::QueryOutputNumber(int index) const {
+    if (index >= 0 && index < outputSize) {
+        return outputNumber[index];
+    }
+    return -1;
+}
+
+int formula::QueryInputSize() const {
     return inputSize;
 }
 
-int formula::QueryOutputSize() {
+int formula::QueryOutputSize() const {
     return outputSize;
 }
 
-bool formula::QueryCompleted() const {
-    return completed;
+// Roll the outcome tier of an Apply
+// Takes the tier from the recorder when it replays a run, otherwise draws it
+// from the random number generator and records it if a recorder is attached.
+int formula::RollTier() {
+    if (recorder && recorder->QueryReplaying()) {
+        return recorder->Next();
+    }
+
+    int randomNum = dis(Generator());
+    int tier;
+    if (randomNum <= failure) {
+        tier = 0;
+    }
+    else if (randomNum <= failure + partial) {
+        tier = 1;
+    }
+    else if (randomNum <= failure + partial + normal) {
+        tier = 2;
+    }
+    else {
+        tier = 3;
+    }
+
+    if (recorder) {
+        recorder->Record(tier);
+    }
+    return tier;
+}
+
+void formula::AttachRecorder(shared_ptr<outcomerecorder> newRecorder) {
+    recorder = std::move(newRecorder);
 }
 
-void formula::ResetCompleted() {
-    completed = false;
+// Seed the random number generator, so the outcomes can be reproduced
+void formula::Seed(unsigned int seed) {
+    if (gen) {
+        gen->seed(seed);
+    }
+    else {
+        gen.reset(new mt19937(seed));
+    }
+    seeded = true;
+    dis.reset();
+    if (fused) {
+        fused->draw.reset();
+    }
 }
 
 string formula::Apply() {
+    if (fused) {
+        return ApplyFused();
+    }
+
     stringstream ssr;
     string result;
-    int randomNum = dis(gen);
-    if (randomNum <= failure) {
+    int tier = RollTier();
+    if (tier == 0) {
         result = "There is nothing produced.";
-        completed = true;
         return result;
     }
-    if (randomNum <= failure + partial) {
+    if (tier == 1) {
         for (int i = 0; i < outputSize; i++) {
             ssr << to_string(outputNumber[i] * 0.75) + " " + outputMaterial[i]
                    + "\n";
         }
         ssr >> result;
         IncreaseExp();
-        completed = true;
         return result;
     }
-    if (randomNum <= failure + partial +normal) {
+    if (tier == 2) {
         for (int i = 0; i < outputSize; i++) {
             ssr << to_string(outputNumber[i]) + " " + outputMaterial[i] + "\n";
         }
         ssr >> result;
         IncreaseExp();
-        completed = true;
         return result;
     }
     else {
@@ -319,7 +426,332 @@ string formula::Apply() {
         }
         ssr >> result;
         IncreaseExp();
-        completed = true;
         return result;
     }
-}
\ No newline at end of file
+}
+
+// Hash Recipe
+// Hashes the input and output materials with their numbers using 64-bit
+// FNV-1a; a separator keeps "ab" + "c" apart from "a" + "bc".
+unsigned long long formula::HashRecipe() const {
+    unsigned long long hashValue = 14695981039346656037ULL;
+    auto mix = [&hashValue](unsigned char byte) {
+        hashValue ^= byte;
+        hashValue *= 1099511628211ULL;
+    };
+    auto mixNumber = [&mix](long long number) {
+        for (int k = 0; k < 8; k++) {
+            mix((unsigned char) (number >> (8 * k)));
+        }
+    };
+
+    mixNumber(inputSize);
+    for (int i = 0; i < inputSize; i++) {
+        for (char c : inputMaterial[i]) {
+            mix((unsigned char) c);
+        }
+        mix(0);
+        mixNumber(inputNumber[i]);
+    }
+    mixNumber(outputSize);
+    for (int j = 0; j < outputSize; j++) {
+        for (char c : outputMaterial[j]) {
+            mix((unsigned char) c);
+        }
+        mix(0);
+        mixNumber(outputNumber[j]);
+    }
+    return hashValue;
+}
+
+// Get the hash of the recipe
+unsigned long long formula::QueryRecipeHash() const {
+    return recipeHash;
+}
+
+// Get the random number generator
+// A generator holds about 5 KB of state, so it is only created when the
+// Formula first rolls; copies of a Formula that never rolled, such as the
+// steps of a large Plan, do not carry one.
+mt19937& formula::Generator() {
+    if (!gen) {
+        gen.reset(new mt19937(DrawSeed()));
+    }
+    return *gen;
+}
+
+// Draw Seed
+// Seeds each Formula's generator from a per-thread generator that is seeded
+// once by random_device; reading a random_device for every Formula made
+// building large Plans slow.
+unsigned int formula::DrawSeed() {
+    static thread_local mt19937 seeder{random_device{}()};
+    return seeder();
+}
+
+// Get the probability of an outcome tier
+// Apply rolls an integer from 0 to 100, so the odds of a tier are the number
+// of rolls that land on it out of 101. The second parameter asks for the
+// odds after that many more level-ups, as far as MAXPRO allows.
+double formula::QueryTierProbability(int tier, int levels) const {
+    levels = max(0, min(levels, MAXPRO - proficiencyLevel));
+    int failureOdds = failure - 5 * levels;
+    int partialOdds = partial - 5 * levels;
+    int normalOdds = normal + 8 * levels;
+    int rolls;
+    if (tier == 0) {
+        rolls = failureOdds + 1;
+    }
+    else if (tier == 1) {
+        rolls = partialOdds;
+    }
+    else if (tier == 2) {
+        rolls = normalOdds;
+    }
+    else if (tier == 3) {
+        rolls = 100 - failureOdds - partialOdds - normalOdds;
+    }
+    else {
+        return 0;
+    }
+    return rolls / 101.0;
+}
+
+// Get the expected output multiplier of one Apply, optionally after more
+// level-ups
+double formula::QueryExpectedYield(int levels) const {
+    double result = 0;
+    if (fused) {
+        // The fused outcomes already combine the steps' odds
+        for (size_t k = 0; k < fused->outcomeMultipliers.size(); k++) {
+            double previous = k == 0 ? 0 : fused->cumulative[k - 1];
+            result += (fused->cumulative[k] - previous) *
+                      fused->outcomeMultipliers[k];
+        }
+        return result;
+    }
+    for (int tier = 0; tier < 4; tier++) {
+        result += QueryTierProbability(tier, levels) *
+                  QueryTierMultiplier(tier);
+    }
+    return result;
+}
+
+// Get how many more successful Applies level the Formula up
+// Experience stops at MAXEXP, so there is no further level-up once it is
+// reached; -1 is returned then, or when the level is already MAXPRO.
+int formula::QueryExperienceToLevel() const {
+    if (experienceNum >= MAXEXP || proficiencyLevel >= MAXPRO) {
+        return -1;
+    }
+    return MAXEXP - experienceNum;
+}
+
+// Get the output multiplier of an outcome tier
+double formula::QueryTierMultiplier(int tier) {
+    static const double multiplier[4] = {0, 0.75, 1, 1.1};
+    if (tier < 0 || tier > 3) {
+        return 0;
+    }
+    return multiplier[tier];
+}
+
+// Fuse
+// Builds one Formula that runs the first Formula and then the second. The
+// second must consume every output of the first in exactly the numbers the
+// first makes, so the outputs never reach the Stockpile. A Plan applies a
+// step without consuming its inputs, so running the steps one by one would
+// leave those outputs in the Stockpile; the fused Formula does not. The
+// second step's input check is folded into the outcome of the first, so it
+// is not repeated against the Stockpile either.
+formula formula::Fuse(const formula& first, const formula& second) {
+    if (first.outputSize == 0) {
+        throw invalid_argument("The first Formula produces nothing.");
+    }
+    for (int j = 0; j < first.outputSize; j++) {
+        int consumed = 0;
+        for (int i = 0; i < second.inputSize; i++) {
+            if (second.inputMaterial[i] == first.outputMaterial[j]) {
+                consumed += second.inputNumber[i];
+            }
+        }
+        if (consumed != first.outputNumber[j]) {
+            throw invalid_argument("The second Formula does not consume "
+                                   "exactly the outputs of the first.");
+        }
+    }
+
+    // The inputs of both, without the chained materials, merged by name
+    vector<pair<string, int>> inputs;
+    auto addInput = [&inputs](const string& material, int number) {
+        for (pair<string, int>& input : inputs) {
+            if (input.first == material) {
+                input.second += number;
+                return;
+            }
+        }
+        inputs.push_back({material, number});
+    };
+    for (int i = 0; i < first.inputSize; i++) {
+        addInput(first.inputMaterial[i], first.inputNumber[i]);
+    }
+    for (int i = 0; i < second.inputSize; i++) {
+        bool chained = false;
+        for (int j = 0; j < first.outputSize; j++) {
+            chained = chained ||
+                      second.inputMaterial[i] == first.outputMaterial[j];
+        }
+        if (!chained) {
+            addInput(second.inputMaterial[i], second.inputNumber[i]);
+        }
+    }
+
+    string* inputM = new string[inputs.size()];
+    int* inputN = new int[inputs.size()];
+    for (size_t i = 0; i < inputs.size(); i++) {
+        inputM[i] = inputs[i].first;
+        inputN[i] = inputs[i].second;
+    }
+    string* outputM = new string[second.outputSize];
+    int* outputN = new int[second.outputSize];
+    for (int j = 0; j < second.outputSize; j++) {
+        outputM[j] = second.outputMaterial[j];
+        outputN[j] = second.outputNumber[j];
+    }
+
+    formula result(inputM, inputN, (int) inputs.size(), outputM, outputN,
+                   second.outputSize);
+    result.fused.reset(new fusion());
+    for (const formula* part : {&first, &second}) {
+        if (part->fused) {
+            for (const formula& step : part->fused->steps) {
+                result.fused->steps.push_back(step);
+            }
+        }
+        else {
+            result.fused->steps.push_back(*part);
+        }
+    }
+    for (formula& step : result.fused->steps) {
+        step.recorder.reset();
+    }
+    result.BuildOutcomes();
+    return result;
+}
+
+// Build Outcomes
+// Enumerates the tier combinations of the fused steps with their current
+// odds; a failed step ends the chain, so later steps do not run
+void formula::BuildOutcomes() {
+    fused->outcomeTiers.clear();
+    fused->outcomeMultipliers.clear();
+    fused->cumulative.clear();
+
+    vector<int> tiers;
+    double total = 0;
+    auto expand = [this, &tiers, &total](auto& self, double probability,
+                                         double multiplier) -> void {
+        size_t index = tiers.size();
+        for (int tier = 0; tier < 4; tier++) {
+            double odds = probability *
+                          fused->steps[index].QueryTierProbability(tier);
+            if (odds <= 0) {
+                continue;
+            }
+            tiers.push_back(tier);
+            double product = multiplier * QueryTierMultiplier(tier);
+            if (tier == 0 || tiers.size() == fused->steps.size()) {
+                total += odds;
+                fused->outcomeTiers.push_back(tiers);
+                fused->outcomeMultipliers.push_back(product);
+                fused->cumulative.push_back(total);
+            }
+            else {
+                self(self, odds, product);
+            }
+            tiers.pop_back();
+        }
+    };
+    expand(expand, 1.0, 1.0);
+}
+
+// Apply Fused
+// Draws one outcome for the whole chain, or replays the steps' tiers, then
+// credits experience to every step that succeeded. The result has the shape
+// of an ordinary Apply: the number made of the first output.
+string formula::ApplyFused() {
+    size_t outcome = 0;
+    if (recorder && recorder->QueryReplaying()) {
+        vector<int> tiers;
+        while (tiers.size() < fused->steps.size() &&
+               (tiers.empty() || tiers.back() != 0)) {
+            tiers.push_back(recorder->Next());
+        }
+        while (outcome < fused->outcomeTiers.size() &&
+               fused->outcomeTiers[outcome] != tiers) {
+            outcome++;
+        }
+        if (outcome == fused->outcomeTiers.size()) {
+            throw runtime_error("The recorded tiers do not fit the fused "
+                                "Formula.");
+        }
+    }
+    else {
+        double roll = fused->draw(Generator()) * fused->cumulative.back();
+        outcome = upper_bound(fused->cumulative.begin(),
+                              fused->cumulative.end(), roll) -
+                  fused->cumulative.begin();
+        outcome = min(outcome, fused->cumulative.size() - 1);
+        if (recorder) {
+            for (int tier : fused->outcomeTiers[outcome]) {
+                recorder->Record(tier);
+            }
+        }
+    }
+
+    const vector<int>& tiers = fused->outcomeTiers[outcome];
+    bool leveled = false;
+    for (size_t k = 0; k < tiers.size(); k++) {
+        formula& step = fused->steps[k];
+        if (tiers[k] > 0) {
+            int level = step.proficiencyLevel;
+            step.IncreaseExp();
+            leveled = leveled || step.proficiencyLevel != level;
+        }
+    }
+    fused->lastTiers = tiers;
+    fused->lastTiers.resize(fused->steps.size(), -1);
+
+    double multiplier = fused->outcomeMultipliers[outcome];
+    if (leveled) {
+        BuildOutcomes();
+    }
+    if (multiplier == 0) {
+        return "There is nothing produced.";
+    }
+    stringstream ssr;
+    string result;
+    for (int i = 0; i < outputSize; i++) {
+        ssr << to_string(outputNumber[i] * multiplier) + " " +
+               outputMaterial[i] + "\n";
+    }
+    ssr >> result;
+    return result;
+}
+
+// Check if the Formula is a fusion of several steps
+bool formula::QueryFused() const {
+    return fused != nullptr;
+}
+
+// Get the steps of a fused Formula, with their current proficiency
+const vector<formula>& formula::QueryFusedSteps() const {
+    static const vector<formula> noSteps;
+    return fused ? fused->steps : noSteps;
+}
+
+// Get the tier of every step in the last Apply of a fused Formula
+// A step that did not run because an earlier one failed gets -1.
+vector<int> formula::QueryFusedTiers() const {
+    return fused ? fused->lastTiers : vector<int>();
+}
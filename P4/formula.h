@@ -8,10 +8,14 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <memory>
 #include <random>
+#include <vector>
 
 using namespace std;
 
+class outcomerecorder;
+
 class formula {
 private:
     string* inputMaterial;
@@ -26,15 +30,27 @@ private:
     int bonus;
     int proficiencyLevel;
     int experienceNum;
-    bool completed;
-    random_device rd;
-    mt19937 gen{rd()};
+    unique_ptr<mt19937> gen;    // Created by the first roll or by Seed
     uniform_int_distribution<> dis{0, 100};
+    bool seeded = false;    // Copies of a seeded Formula continue its rolls
     const int MAXEXP = 6;
     const int MAXPRO = 2;
+    shared_ptr<outcomerecorder> recorder;
+    unsigned long long recipeHash;
+
+    // The steps of a fused Formula and the combined distribution of their
+    // outcomes; null for an ordinary Formula.
+    struct fusion;
+    unique_ptr<fusion> fused;
 
     void IncreaseExp();
     void IncreaseLevel();
+    int RollTier();
+    mt19937& Generator();
+    static unsigned int DrawSeed();
+    unsigned long long HashRecipe() const;
+    void BuildOutcomes();
+    string ApplyFused();
 
 public:
     formula();
@@ -48,15 +64,35 @@ public:
     formula& operator=(formula&&) noexcept;
     string QueryInput();
     string QueryOutput();
-    string QueryInputMaterial(int) const;
-    string QueryOutputMaterial(int) const;
+    const string& QueryInputMaterial(int) const;
+    const string& QueryOutputMaterial(int) const;
     int QueryInputNumber(int) const;
-    int QueryInputSize();
-    int QueryOutputSize();
-    bool QueryCompleted() const;
-    void ResetCompleted();
+    int QueryOutputNumber(int) const;
+    int QueryInputSize() const;
+    int QueryOutputSize() const;
     string Apply();
+    void AttachRecorder(shared_ptr<outcomerecorder>);
+    void Seed(unsigned int);
+    unsigned long long QueryRecipeHash() const;
+    double QueryTierProbability(int, int = 0) const;
+    double QueryExpectedYield(int = 0) const;
+    int QueryExperienceToLevel() const;
+    static double QueryTierMultiplier(int);
+    static formula Fuse(const formula&, const formula&);
+    bool QueryFused() const;
+    const vector<formula>& QueryFusedSteps() const;
+    vector<int> QueryFusedTiers() const;
 };
 
+namespace std {
+    // Hash a Formula by its recipe, so equal Formulas share a hash.
+    template <>
+    struct hash<formula> {
+        size_t operator()(const formula& target) const noexcept {
+            return (size_t) target.QueryRecipeHash();
+        }
+    };
+}
+
 
 #endif //P4_FORMULA_H
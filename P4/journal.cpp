@@ -0,0 +1,186 @@
+// AUTHOR:      Hongru He
+// FILENAME:    journal.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "journal.h"
+#include <stdexcept>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Material names are interned once, so every event is a fixed-size
+//      record in a contiguous vector and replay streams through it without
+//      parsing.
+// 2.   Snapshots are ordered by event index; snapshots[0] is the base state
+//      of the kept events after a compaction.
+// 3.   currentStep and generation always mirror the last Apply or Reset
+//      event, so snapshots taken from the Stockpile side still carry the
+//      plan state.
+
+// Default Constructor
+journal::journal() : journal(0) {}
+
+// Overloaded Constructor
+journal::journal(int interval) {
+    if (interval < 0) {
+        throw invalid_argument("Snapshot interval cannot be negative.");
+    }
+    firstIndex = 0;
+    lastSnapshotIndex = 0;
+    snapshotInterval = interval;
+    currentStep = 0;
+    generation = 0;
+}
+
+// Intern Material
+// Returns the id of a material name, adding it to the table if it is new.
+unsigned int journal::InternMaterial(const string& material) {
+    auto item = materialIds.find(material);
+    if (item != materialIds.end()) {
+        return item->second;
+    }
+    unsigned int id = materialNames.size();
+    materialNames.push_back(material);
+    materialIds.emplace(material, id);
+    return id;
+}
+
+// Append
+// Appends an event and snapshots the Stockpile every snapshotInterval events.
+void journal::Append(eventtype type, unsigned int subject, double amount,
+                     const stockpile* current) {
+    events.push_back({type, subject, amount});
+
+    if (current != nullptr && snapshotInterval > 0 &&
+        QueryEventCount() - lastSnapshotIndex >=
+        (unsigned long long) snapshotInterval) {
+        Snapshot(*current);
+    }
+}
+
+// Record Increase
+void journal::RecordIncrease(const string& material, double amount,
+                             const stockpile& current) {
+    Append(eventtype::Increase, InternMaterial(material), amount, &current);
+}
+
+// Record Decrease
+void journal::RecordDecrease(const string& material, double amount,
+                             const stockpile& current) {
+    Append(eventtype::Decrease, InternMaterial(material), amount, &current);
+}
+
+// Record Apply
+void journal::RecordApply(int step, unsigned long gen) {
+    currentStep = step;
+    generation = gen;
+    Append(eventtype::Apply, step, gen, nullptr);
+}
+
+// Record Reset
+void journal::RecordReset(int step, unsigned long gen) {
+    currentStep = step;
+    generation = gen;
+    Append(eventtype::Reset, step, gen, nullptr);
+}
+
+// Snapshot
+// Stores the Stockpile and the latest plan state at the current index.
+void journal::Snapshot(const stockpile& current) {
+    snapshot taken;
+    taken.eventIndex = QueryEventCount();
+    taken.state.resources = current;
+    taken.state.currentStep = currentStep;
+    taken.state.generation = generation;
+    snapshots.push_back(std::move(taken));
+    lastSnapshotIndex = QueryEventCount();
+}
+
+// Apply Event
+void journal::ApplyEvent(const journalevent& event,
+                         const vector<string>& names, journalstate& state) {
+    switch (event.type) {
+        case eventtype::Increase:
+            state.resources.IncreaseResource(names[event.subject],
+                                             event.amount);
+            break;
+        case eventtype::Decrease:
+            state.resources.DecreaseResource(names[event.subject],
+                                             (int) event.amount);
+            break;
+        case eventtype::Apply:
+        case eventtype::Reset:
+            state.currentStep = (int) event.subject;
+            state.generation = (unsigned long) event.amount;
+            break;
+    }
+}
+
+// Replay
+journalstate journal::Replay() const {
+    return Replay(QueryEventCount());
+}
+
+// Replay
+// Starts from the nearest snapshot and applies the events after it.
+journalstate journal::Replay(unsigned long long index) const {
+    if (index < firstIndex || index > QueryEventCount()) {
+        throw out_of_range("Event index is not kept in the journal.");
+    }
+
+    journalstate state;
+    unsigned long long start = firstIndex;
+
+    // Snapshots are sorted, so the nearest one is found by binary search.
+    int low = 0, high = (int) snapshots.size() - 1, nearest = -1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (snapshots[mid].eventIndex <= index) {
+            nearest = mid;
+            low = mid + 1;
+        }
+        else {
+            high = mid - 1;
+        }
+    }
+    if (nearest >= 0) {
+        state = snapshots[nearest].state;
+        start = snapshots[nearest].eventIndex;
+    }
+
+    for (unsigned long long i = start; i < index; i++) {
+        ApplyEvent(events[i - firstIndex], materialNames, state);
+    }
+
+    return state;
+}
+
+// Compact
+// Drops the events and snapshots that the latest snapshot already covers.
+void journal::Compact() {
+    if (snapshots.empty()) {
+        return;
+    }
+
+    unsigned long long base = snapshots.back().eventIndex;
+    events.erase(events.begin(), events.begin() + (base - firstIndex));
+    events.shrink_to_fit();
+    snapshots.erase(snapshots.begin(), snapshots.end() - 1);
+    firstIndex = base;
+}
+
+// Get the global index just past the last event
+unsigned long long journal::QueryEventCount() const {
+    return firstIndex + events.size();
+}
+
+// Get the global index of the first kept event
+unsigned long long journal::QueryFirstIndex() const {
+    return firstIndex;
+}
+
+// Get the number of kept snapshots
+int journal::QuerySnapshotCount() const {
+    return snapshots.size();
+}
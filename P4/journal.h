@@ -0,0 +1,160 @@
+// AUTHOR:      Hongru He
+// FILENAME:    journal.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_JOURNAL_H
+#define P4_JOURNAL_H
+#include "stockpile.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// The kinds of events recorded in a Journal.
+enum class eventtype : unsigned char {
+    Increase,
+    Decrease,
+    Apply,
+    Reset
+};
+
+// One compact binary event of a Journal.
+// For Increase and Decrease events the subject is the interned material id
+// and the amount is the quantity. For Apply and Reset events the subject is
+// the current step of the plan afterwards and the amount is its generation.
+struct journalevent {
+    eventtype type;
+    unsigned int subject;
+    double amount;
+};
+
+// The state of a warehouse reconstructed from a Journal.
+struct journalstate {
+    stockpile resources;
+    int currentStep = 0;
+    unsigned long generation = 0;
+};
+
+// The Journal class keeps an append-only history of the mutations done on a
+// Stockpile and the steps applied by an ExecutablePlan.
+// Class Invariants:
+// 1.   Events are never modified once appended; they are only dropped by
+//      compaction after being folded into a snapshot.
+// 2.   Every snapshot holds the exact state after all events with a lower
+//      index, so replay can start from the nearest snapshot.
+// 3.   Event indices are global and keep counting across compactions.
+
+class journal {
+private:
+    struct snapshot {
+        unsigned long long eventIndex;
+        journalstate state;
+    };
+
+    vector<journalevent> events;
+    vector<snapshot> snapshots;
+    vector<string> materialNames;
+    unordered_map<string, unsigned int> materialIds;
+    unsigned long long firstIndex;
+    unsigned long long lastSnapshotIndex;
+    int snapshotInterval;
+    int currentStep;
+    unsigned long generation;
+
+    unsigned int InternMaterial(const string&);
+    // Get the id of a material, assigning a new one if necessary
+
+    void Append(eventtype, unsigned int, double, const stockpile*);
+    // Append an event and take a periodic snapshot when it is due
+
+    static void ApplyEvent(const journalevent&, const vector<string>&,
+                           journalstate&);
+    // Apply one event to a reconstructed state
+
+public:
+    journal();
+    // Default Constructor
+    // Explanation:     Initializes an empty Journal without periodic
+    //                  snapshots.
+    // Precondition:    None.
+    // Postcondition:   Journal object is initialized with default setting.
+
+    explicit journal(int);
+    // Overloaded Constructor
+    // Explanation:     Initializes an empty Journal that snapshots the
+    //                  Stockpile every given number of events.
+    // Precondition:    The parameter is not negative; 0 disables periodic
+    //                  snapshots.
+    // Postcondition:   Journal object is initialized with the interval.
+
+    void RecordIncrease(const string&, double, const stockpile&);
+    // Record an increase of a resource
+    // Explanation:     Appends an Increase event. The Stockpile is the state
+    //                  after the mutation and is used for periodic snapshots.
+    // Precondition:    None.
+    // Postcondition:   The event is appended to the Journal.
+
+    void RecordDecrease(const string&, double, const stockpile&);
+    // Record a decrease of a resource
+    // Explanation:     Appends a Decrease event. The Stockpile is the state
+    //                  after the mutation and is used for periodic snapshots.
+    // Precondition:    The decrease succeeded.
+    // Postcondition:   The event is appended to the Journal.
+
+    void RecordApply(int, unsigned long);
+    // Record a step applied by an ExecutablePlan
+    // Explanation:     Appends an Apply event with the plan's current step
+    //                  and generation after the step.
+    // Precondition:    None.
+    // Postcondition:   The event is appended to the Journal.
+
+    void RecordReset(int, unsigned long);
+    // Record a reset of an ExecutablePlan
+    // Explanation:     Appends a Reset event with the plan's current step
+    //                  and generation after the reset.
+    // Precondition:    None.
+    // Postcondition:   The event is appended to the Journal.
+
+    void Snapshot(const stockpile&);
+    // Take a snapshot of the current state
+    // Explanation:     Stores a copy of the Stockpile together with the plan
+    //                  state known from the recorded events.
+    // Precondition:    The Stockpile reflects every recorded event.
+    // Postcondition:   A snapshot at the current event index is stored.
+
+    journalstate Replay() const;
+    // Reconstruct the latest state
+    // Explanation:     Replays the Journal up to its last event.
+    // Precondition:    None.
+    // Postcondition:   Returns the state without modifying the Journal.
+
+    journalstate Replay(unsigned long long) const;
+    // Reconstruct the state after a given number of events
+    // Explanation:     Starts from the nearest snapshot at or below the
+    //                  index and streams the events after it.
+    // Precondition:    The index is not below the first kept event, which
+    //                  moves forward on compaction.
+    // Postcondition:   Returns the state without modifying the Journal.
+
+    void Compact();
+    // Fold old events into the latest snapshot
+    // Explanation:     Drops every event and snapshot older than the latest
+    //                  snapshot.
+    // Precondition:    None.
+    // Postcondition:   Replay of any index from the latest snapshot on gives
+    //                  the same result as before.
+
+    unsigned long long QueryEventCount() const;
+    // Get the global index just past the last event
+
+    unsigned long long QueryFirstIndex() const;
+    // Get the global index of the first kept event
+
+    int QuerySnapshotCount() const;
+    // Get the number of kept snapshots
+};
+
+
+#endif //P4_JOURNAL_H
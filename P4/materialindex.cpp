@@ -0,0 +1,83 @@
+// AUTHOR:      Hongru He
+// FILENAME:    materialindex.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "materialindex.h"
+#include <algorithm>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Insert links all materials of one Formula in a row, so a duplicate
+//      material always finds the id at the back of its list.
+// 2.   Owners mostly erase their newest ids (a Plan removes its last step),
+//      so Unlink searches from the back and is usually O(1).
+// 3.   Entries whose lists become empty are kept; they cost one slot and
+//      save a rehash when the material comes back.
+
+// Link
+// Adds the id to the list unless the same Formula already added it
+void materialindex::Link(vector<int>& ids, int id) {
+    if (ids.empty() || ids.back() != id) {
+        ids.push_back(id);
+    }
+}
+
+// Unlink
+// Removes the id from the list if it is there
+void materialindex::Unlink(vector<int>& ids, int id) {
+    auto found = find(ids.rbegin(), ids.rend(), id);
+    if (found != ids.rend()) {
+        ids.erase(next(found).base());
+    }
+}
+
+// Insert
+// Indexes the materials of a Formula under the id
+void materialindex::Insert(int id, const formula& target) {
+    for (int i = 0; i < target.QueryInputSize(); i++) {
+        Link(materials[target.QueryInputMaterial(i)].consumers, id);
+    }
+    for (int j = 0; j < target.QueryOutputSize(); j++) {
+        Link(materials[target.QueryOutputMaterial(j)].producers, id);
+    }
+}
+
+// Erase
+// Removes the id from the lists of every material of the Formula
+void materialindex::Erase(int id, const formula& target) {
+    for (int i = 0; i < target.QueryInputSize(); i++) {
+        auto item = materials.find(target.QueryInputMaterial(i));
+        if (item != materials.end()) {
+            Unlink(item->second.consumers, id);
+        }
+    }
+    for (int j = 0; j < target.QueryOutputSize(); j++) {
+        auto item = materials.find(target.QueryOutputMaterial(j));
+        if (item != materials.end()) {
+            Unlink(item->second.producers, id);
+        }
+    }
+}
+
+// Clear
+void materialindex::Clear() {
+    materials.clear();
+}
+
+// Query Producers
+const vector<int>& materialindex::QueryProducers(const string& material)
+        const {
+    static const vector<int> noFormulas;
+    auto item = materials.find(material);
+    return item == materials.end() ? noFormulas : item->second.producers;
+}
+
+// Query Consumers
+const vector<int>& materialindex::QueryConsumers(const string& material)
+        const {
+    static const vector<int> noFormulas;
+    auto item = materials.find(material);
+    return item == materials.end() ? noFormulas : item->second.consumers;
+}
@@ -0,0 +1,71 @@
+// AUTHOR:      Hongru He
+// FILENAME:    materialindex.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_MATERIALINDEX_H
+#define P4_MATERIALINDEX_H
+#include "formula.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// The MaterialIndex class maps every material to the ids of the Formulas
+// that produce it and the ids of the Formulas that consume it. The owner
+// picks the ids: a RecipeCatalog uses its recipe ids and a Plan uses its
+// step indices.
+// Class Invariants:
+// 1.   An id appears at most once in each list, even if its Formula names
+//      the same material twice.
+// 2.   A lookup costs one hash of the name plus the size of the result.
+
+class materialindex {
+private:
+    struct entry {
+        vector<int> producers;
+        vector<int> consumers;
+    };
+
+    unordered_map<string, entry> materials;
+
+    static void Link(vector<int>&, int);
+    // Add an id to a list unless it was just added
+
+    static void Unlink(vector<int>&, int);
+    // Remove an id from a list, searching from the most recent one
+
+public:
+    void Insert(int, const formula&);
+    // Index a Formula
+    // Explanation:     Adds the id to the producers of every output and the
+    //                  consumers of every input.
+    // Precondition:    The id is not indexed yet.
+    // Postcondition:   Lookups of the Formula's materials include the id.
+
+    void Erase(int, const formula&);
+    // Remove a Formula from the index
+    // Explanation:     Removes the id from the lists of every material of
+    //                  the Formula.
+    // Precondition:    The Formula is the one indexed with the id.
+    // Postcondition:   No lookup returns the id.
+
+    void Clear();
+    // Remove every Formula from the index
+
+    const vector<int>& QueryProducers(const string&) const;
+    // Get the ids of the Formulas that produce a material
+    // Explanation:     The ids are in no particular order.
+    // Precondition:    None.
+    // Postcondition:   Return an empty list for an unknown material.
+
+    const vector<int>& QueryConsumers(const string&) const;
+    // Get the ids of the Formulas that consume a material
+    // Explanation:     The ids are in no particular order.
+    // Precondition:    None.
+    // Postcondition:   Return an empty list for an unknown material.
+};
+
+
+#endif //P4_MATERIALINDEX_H
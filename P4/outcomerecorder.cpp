@@ -0,0 +1,113 @@
+// AUTHOR:      Hongru He
+// FILENAME:    outcomerecorder.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "outcomerecorder.h"
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Recording is a shift and an or into the last word, so it costs a few
+//      nanoseconds per Apply.
+// 2.   The file layout is a four byte tag, the outcome count and the packed
+//      words, all in the byte order of the machine that wrote it.
+
+static const char RECORDER_TAG[4] = {'P', '4', 'O', 'R'};
+
+// Default Constructor
+outcomerecorder::outcomerecorder() {
+    count = 0;
+    position = 0;
+    replaying = false;
+}
+
+// Record an outcome tier
+void outcomerecorder::Record(int tier) {
+    if (replaying) {
+        throw logic_error("Cannot record outcomes while replaying.");
+    }
+    if (count % 32 == 0) {
+        words.push_back(0);
+    }
+    words.back() |= (unsigned long long) (tier & 3) << (2 * (count % 32));
+    count++;
+}
+
+// Get the next recorded outcome tier
+int outcomerecorder::Next() {
+    if (position >= count) {
+        throw out_of_range("There is no more recorded outcome.");
+    }
+    int tier = (int) ((words[position / 32] >> (2 * (position % 32))) & 3);
+    position++;
+    return tier;
+}
+
+// Discard the recorded outcomes and record a new run
+void outcomerecorder::StartRecording() {
+    words.clear();
+    count = 0;
+    position = 0;
+    replaying = false;
+}
+
+// Replay the recorded outcomes from the beginning
+void outcomerecorder::StartReplay() {
+    position = 0;
+    replaying = true;
+}
+
+// Check if the recorder feeds outcomes instead of recording them
+bool outcomerecorder::QueryReplaying() const {
+    return replaying;
+}
+
+// Get the number of recorded outcomes
+unsigned long long outcomerecorder::QuerySize() const {
+    return count;
+}
+
+// Write the recorded outcomes to a binary file
+void outcomerecorder::Save(const string& path) const {
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file) {
+        throw runtime_error("Cannot open " + path + " for writing.");
+    }
+    file.write(RECORDER_TAG, sizeof(RECORDER_TAG));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(words.data()),
+               words.size() * sizeof(unsigned long long));
+    if (!file) {
+        throw runtime_error("Cannot write outcomes to " + path + ".");
+    }
+}
+
+// Read recorded outcomes from a binary file and start replaying them
+void outcomerecorder::Load(const string& path) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        throw runtime_error("Cannot open " + path + " for reading.");
+    }
+
+    char tag[4];
+    unsigned long long loadedCount = 0;
+    file.read(tag, sizeof(tag));
+    file.read(reinterpret_cast<char*>(&loadedCount), sizeof(loadedCount));
+    if (!file || string(tag, 4) != string(RECORDER_TAG, 4)) {
+        throw runtime_error(path + " is not an outcome recording.");
+    }
+
+    vector<unsigned long long> loadedWords((loadedCount + 31) / 32);
+    file.read(reinterpret_cast<char*>(loadedWords.data()),
+              loadedWords.size() * sizeof(unsigned long long));
+    if (!file) {
+        throw runtime_error(path + " is truncated.");
+    }
+
+    words = std::move(loadedWords);
+    count = loadedCount;
+    StartReplay();
+}
@@ -0,0 +1,72 @@
+// AUTHOR:      Hongru He
+// FILENAME:    outcomerecorder.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_OUTCOMERECORDER_H
+#define P4_OUTCOMERECORDER_H
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The OutcomeRecorder class keeps the sequence of outcome tiers produced by
+// Formula's Apply, two bits per outcome, and can feed them back in place of
+// the random number generator.
+// Tiers are numbered 0 for failure, 1 for partial, 2 for normal and 3 for
+// bonus.
+// Class Invariants:
+// 1.   Outcome i is stored in bits 2 * (i % 32) of word i / 32.
+// 2.   In replay mode the recorded sequence is never modified, and outcomes
+//      are handed out in the order they were recorded.
+
+class outcomerecorder {
+private:
+    vector<unsigned long long> words;
+    unsigned long long count;
+    unsigned long long position;
+    bool replaying;
+
+public:
+    outcomerecorder();
+    // Default Constructor
+    // Explanation:     Initializes an empty recorder in recording mode.
+    // Precondition:    None.
+    // Postcondition:   OutcomeRecorder object is initialized with default
+    //                  setting.
+
+    void Record(int);
+    // Record an outcome tier
+    // Explanation:     Appends the tier to the bit-packed sequence.
+    // Precondition:    The recorder is in recording mode and the tier is
+    //                  between 0 and 3.
+    // Postcondition:   The sequence is one outcome longer.
+
+    int Next();
+    // Get the next recorded outcome tier
+    // Explanation:     Returns the outcome at the replay position and moves
+    //                  past it.
+    // Precondition:    The recorder is in replay mode and not exhausted.
+    // Postcondition:   The replay position is advanced.
+
+    void StartRecording();
+    // Discard the recorded outcomes and record a new run
+
+    void StartReplay();
+    // Replay the recorded outcomes from the beginning
+
+    bool QueryReplaying() const;
+    // Check if the recorder feeds outcomes instead of recording them
+
+    unsigned long long QuerySize() const;
+    // Get the number of recorded outcomes
+
+    void Save(const string&) const;
+    // Write the recorded outcomes to a binary file
+
+    void Load(const string&);
+    // Read recorded outcomes from a binary file and start replaying them
+};
+
+
+#endif //P4_OUTCOMERECORDER_H
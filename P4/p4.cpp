@@ -26,9 +26,34 @@
 #include "formula.h"
 #include "executableplan.h"
 #include "stockpile.h"
+#include "journal.h"
+#include "outcomerecorder.h"
+#include "writeaheadlog.h"
+#include "sharedstockpile.h"
+#include "fixedstockpile.h"
+#include "recipe.h"
+#include "recipecatalog.h"
+#include "craftabilityindex.h"
+#include "craftabilitysolver.h"
+#include "productionplanner.h"
+#include "recipematrix.h"
+#include "throughputsolver.h"
+#include "planoptimizer.h"
+#include "planfusion.h"
+#include "replanner.h"
+#include "plandag.h"
+#include "bottleneckanalyzer.h"
+#include "stationscheduler.h"
+#include <map>
+#include <unordered_set>
+#include <cmath>
+#include <cstdio>
 
 using namespace std;
 
+enum class material { Oxygen, Hydrogen, Water, Powder, Sugar, Cookie, Count };
+// The fixed set of materials of the embedded demonstration
+
 stockpile createStockpile1();
 // Create a new stockpile with given parameters
 
@@ -77,6 +102,78 @@ void testEPMoveConstructor();
 void testEPMoveAssignment();
 // Test the move assignment operator of executable plan
 
+void testCyclicExecution();
+// Test the cyclic mode and constant-time reset of executable plan
+
+void testJournalReplay();
+// Test the replay and compaction of the execution journal
+
+void testOutcomeReplay();
+// Test recording and replaying the outcomes of formulas
+
+void testWriteAheadLog();
+// Test the durable updates and recovery of stockpile
+
+void testSharedStockpile();
+// Test reading a stockpile through shared memory
+
+void testStockpileAlgebra();
+// Test the bulk operations of Stockpile
+
+void testStockpileWatchers();
+// Test the threshold and change watchers of Stockpile
+
+void testStockpileReport();
+// Test the streaming reports of Stockpile
+
+void testFrozenStockpile();
+// Test the perfect hash lookups of a frozen Stockpile
+
+void testFixedStockpile();
+// Test the enum-keyed Stockpile and Formula specializations
+
+void testRecipeDSL();
+// Test declaring formulas and plans at compile time
+
+void testContentHashing();
+// Test the hashes of Formula and Plan
+
+void testMaterialIndex();
+// Test the lookups of producing and consuming formulas
+
+void testCraftabilityIndex();
+// Test the craftable counts kept up to date with a Stockpile
+
+void testDeepCraftability();
+// Test the quantities obtainable through chains of recipes
+
+void testProductionPlanner();
+// Test planning the crafts for a bill of materials
+
+void testRecipeMatrix();
+// Test running batches of crafts as sparse matrix products
+
+void testThroughputSolver();
+// Test the recipe mix that maximizes an output
+
+void testPlanOptimizer();
+// Test reordering the steps of a plan for a better expected output
+
+void testFormulaFusion();
+// Test fusing chained steps of a plan into one formula
+
+void testReplanner();
+// Test repairing the rest of a plan after a failed step
+
+void testParallelExecution();
+// Test running the independent steps of a plan concurrently
+
+void testBottleneckAnalysis();
+// Test the critical path, slack and shortages of a plan
+
+void testStationScheduler();
+// Test scheduling the steps of a plan on several stations
+
 int main() {
 
     testIncreaseSP();
@@ -90,6 +187,30 @@ int main() {
     testPlanOverloadedRelationalOperator();
     testEPOverloadedRelationalOperator();
     testOverloadedArithmeticOperator();
+    testCyclicExecution();
+    testJournalReplay();
+    testOutcomeReplay();
+    testWriteAheadLog();
+    testSharedStockpile();
+    testStockpileAlgebra();
+    testStockpileWatchers();
+    testStockpileReport();
+    testFrozenStockpile();
+    testFixedStockpile();
+    testRecipeDSL();
+    testContentHashing();
+    testMaterialIndex();
+    testCraftabilityIndex();
+    testDeepCraftability();
+    testProductionPlanner();
+    testRecipeMatrix();
+    testThroughputSolver();
+    testPlanOptimizer();
+    testFormulaFusion();
+    testReplanner();
+    testParallelExecution();
+    testBottleneckAnalysis();
+    testStationScheduler();
 
     return 0;
 }
@@ -415,4 +536,1319 @@ void testEPMoveAssignment() {
 
     cout << "The Formulas in second Plan after move assignment is:\n"
          << EP2.DisplayFormula() << endl;
-}
\ No newline at end of file
+}
+
+void testCyclicExecution() {
+    cout << "\n----------TEST EXECUTABLE PLAN'S CYCLIC EXECUTION----------\n";
+
+    formula* inputFormulas = createNewFormulaArray1();
+
+    executableplan EP1(inputFormulas, 2);
+    EP1.SetCyclic(true);
+    EP1.EnableCycleStatistics(true);
+
+    for (int i = 0; i < 10; i++) {
+        EP1.ApplyCurrentStep();
+    }
+
+    cyclestatistics stats = EP1.QueryCycleStatistics();
+    cout << "\nCompleted cycles: " << stats.cycles
+         << "\nFailed steps in the last cycle: " << stats.lastCycleFailedSteps
+         << "\nFailed steps in total: " << stats.totalFailedSteps << "\n";
+
+    EP1.SetCyclic(false);
+    EP1.ApplyCurrentStep();
+    EP1.Reset();
+
+    if (!EP1.QueryStepCompleted(0) && EP1.QueryGeneration() == 6) {
+        cout << "\nTest of executable plan's constant-time reset passed.\n";
+    }
+
+    // A failed Apply leaves the Formula as it was, so it still equals a
+    // copy taken before the run.
+    formula fresh = inputFormulas[0];
+    bool nothingProduced = false;
+    for (unsigned int seed = 0; seed < 100 && !nothingProduced; seed++) {
+        formula applied = fresh;
+        applied.Seed(seed);
+        nothingProduced = applied.Apply() == "There is nothing produced.";
+        if (nothingProduced && applied == fresh) {
+            cout << "Test of formula equality after a run passed.\n";
+        }
+    }
+}
+
+
+void testJournalReplay() {
+    cout << "\n----------TEST JOURNAL REPLAY----------\n";
+
+    shared_ptr<journal> log = make_shared<journal>(4);
+    shared_ptr<stockpile> SP1 = make_shared<stockpile>(createStockpile1());
+    SP1->AttachJournal(log);
+
+    executableplan EP1(createNewFormulaArray1(), 2);
+    EP1.AttachJournal(log);
+
+    SP1->IncreaseResource("Powder", 5);
+    SP1->DecreaseResource("Sugar", 4);
+    unsigned long long middle = log->QueryEventCount();
+
+    for (int i = 0; i < 10; i++) {
+        SP1->IncreaseResource("Oxygen", 1);
+    }
+    EP1.ApplyCurrentStep();
+
+    journalstate before = log->Replay(middle);
+    journalstate latest = log->Replay();
+    cout << "\nThe replayed stockpile in the middle includes resources:\n"
+         << before.resources.QueryResources();
+
+    log->Compact();
+    journalstate compacted = log->Replay();
+
+    // Assigning would replace the resources behind the journal's back
+    unsigned long long events = log->QueryEventCount();
+    bool refused = false;
+    try {
+        *SP1 = createStockpile2();
+    }
+    catch (logic_error& e) {
+        refused = log->QueryEventCount() == events &&
+                  SP1->QueryQuantity("Oxygen") == 69;
+    }
+
+    if (latest.resources.QueryQuantity("Oxygen") == 69 &&
+        compacted.resources.QueryQuantity("Oxygen") == 69 &&
+        compacted.currentStep == 1 && log->QuerySnapshotCount() == 1 &&
+        refused) {
+        cout << "\nTest of journal replay and compaction passed.\n";
+    }
+}
+
+
+void testOutcomeReplay() {
+    cout << "\n----------TEST OUTCOME RECORDING AND REPLAY----------\n";
+
+    shared_ptr<outcomerecorder> recorder = make_shared<outcomerecorder>();
+
+    executableplan EP1(createNewFormulaArray1(), 2);
+    EP1.SetCyclic(true);
+    EP1.AttachRecorder(recorder);
+
+    string recorded, replayed;
+    for (int i = 0; i < 20; i++) {
+        recorded += EP1.ApplyCurrentStep() + "\n";
+    }
+
+    recorder->StartReplay();
+    executableplan EP2(createNewFormulaArray1(), 2);
+    EP2.SetCyclic(true);
+    EP2.AttachRecorder(recorder);
+    for (int i = 0; i < 20; i++) {
+        replayed += EP2.ApplyCurrentStep() + "\n";
+    }
+
+    if (recorded == replayed && recorder->QuerySize() == 20) {
+        cout << "\nTest of outcome recording and replay passed.\n";
+    }
+}
+
+
+void testWriteAheadLog() {
+    cout << "\n----------TEST WRITE-AHEAD LOG----------\n";
+
+    string logPath = "p4_stockpile.wal";
+    remove(logPath.c_str());
+
+    {
+        stockpile SP1 = createStockpile1();
+        SP1.AttachWriteAheadLog(make_shared<writeaheadlog>(logPath));
+        for (int i = 0; i < 1000; i++) {
+            SP1.IncreaseResource("Sugar", 1);
+        }
+        SP1.DecreaseResource("Powder", 5);
+    }
+
+    stockpile SP2 = writeaheadlog::Recover(logPath);
+    cout << "\nThe recovered stockpile includes resources:\n"
+         << SP2.QueryResources();
+
+    shared_ptr<writeaheadlog> log = make_shared<writeaheadlog>(logPath);
+    SP2.AttachWriteAheadLog(log);
+    SP2.IncreaseResource("Cookie", 2);
+    unsigned long long sequence = SP2.QueryLastSequence();
+    log->WaitDurable(sequence);
+
+    stockpile SP3 = writeaheadlog::Recover(logPath);
+    if (sequence > 0 && sequence == log->QueryLastSequence() &&
+        SP3.QueryQuantity("Sugar") == 1024 &&
+        SP3.QueryQuantity("Powder") == 12 &&
+        SP3.QueryQuantity("Cookie") == 2) {
+        cout << "\nTest of write-ahead log recovery passed.\n";
+    }
+    remove(logPath.c_str());
+
+#ifndef _WIN32
+    // A log that cannot be synced never reports a record as durable
+    shared_ptr<writeaheadlog> full = make_shared<writeaheadlog>("/dev/full",
+                                                                1, 0);
+    unsigned long long lost = full->Append(eventtype::Increase, "Sugar", 1);
+    bool refused = false;
+    try {
+        full->WaitDurable(lost);
+    }
+    catch (runtime_error& e) {
+        refused = full->QueryDurableSequence() == 0;
+    }
+    try {
+        full->Append(eventtype::Increase, "Sugar", 1);
+        refused = false;
+    }
+    catch (runtime_error& e) {
+        cout << "\n" << e.what() << "\n";
+    }
+    if (refused) {
+        cout << "\nTest of write-ahead log failure passed.\n";
+    }
+#endif
+}
+
+
+void testSharedStockpile() {
+    cout << "\n----------TEST SHARED MEMORY STOCKPILE----------\n";
+
+    try {
+        stockpile SP1 = createStockpile1();
+        SP1.AttachSharedMemory(make_shared<sharedstockpile>("p4_stockpile",
+                                                            64));
+
+        sharedstockpile reader("p4_stockpile");
+        SP1.IncreaseResource("Cookie", 3);
+        SP1.DecreaseResource("Oxygen", 9);
+
+        cout << "\nThe reader sees resources:\n" << reader.QueryResources();
+
+        // A second writer cannot take over the segment
+        bool taken = false;
+        try {
+            sharedstockpile intruder("p4_stockpile", 64);
+        }
+        catch (const runtime_error&) {
+            taken = true;
+        }
+
+        // A name the segment cannot hold leaves the stockpile unchanged
+        string longName(sharedstockpile::NAMESIZE, 'x');
+        bool rejected = false;
+        try {
+            SP1.IncreaseResource(longName, 1);
+        }
+        catch (const invalid_argument&) {
+            rejected = true;
+        }
+
+        if (rejected && taken && SP1.QueryQuantity(longName) == -1 &&
+            reader.QueryQuantity("Cookie") == 3 &&
+            reader.QueryQuantity("Oxygen") == 50 &&
+            reader.QueryQuantity("Apple") == -1) {
+            cout << "\nTest of shared memory stockpile passed.\n";
+        }
+    }
+    catch (const exception& e) {
+        cout << "Exception caught: " << e.what() << endl;
+    }
+}
+
+
+void testStockpileAlgebra() {
+    cout << "\n----------TEST STOCKPILE BULK OPERATIONS----------\n";
+
+    stockpile SP1 = createStockpile1();
+    stockpile SP2 = createStockpile2();
+
+    SP1 += SP2;
+    cout << "\nThe merged stockpile includes resources:\n"
+         << SP1.QueryResources();
+
+    SP1 -= SP2;
+    SP1 *= 2;
+
+    bool rejected = false;
+    try {
+        SP2 -= SP1;
+    }
+    catch (const runtime_error&) {
+        rejected = true;
+    }
+
+    // A negative entry for a resource this Stockpile lacks is rejected
+    stockpile debt;
+    debt.IncreaseResource("Gold", -1);
+    bool negative = false;
+    try {
+        SP1 -= debt;
+    }
+    catch (const invalid_argument&) {
+        negative = SP1.QueryQuantity("Gold") == -1;
+    }
+
+    stockpile SP3 = SP1.Min(SP2);
+    if (rejected && negative && SP1.Covers(SP3) && !SP2.Covers(SP1) &&
+        SP1.QueryQuantity("Oxygen") == 118 && SP3.QueryQuantity("Grain") == 0
+        && SP3.QueryQuantity("Powder") == 0) {
+        cout << "\nTest of stockpile bulk operations passed.\n";
+    }
+}
+
+
+void testStockpileWatchers() {
+    cout << "\n----------TEST STOCKPILE WATCHERS----------\n";
+
+    stockpile SP1 = createStockpile1();
+    int lowSugar = 0, changes = 0;
+
+    SP1.WatchThreshold("Sugar", 10, [&](const string& name, double before,
+                                        double after) {
+        if (after < before) {
+            cout << "\n" << name << " dropped below 10, replenishing.\n";
+            lowSugar++;
+            SP1.IncreaseResource(name, 20);
+        }
+    });
+    int watchId = SP1.WatchChanges({"Powder", "Water"},
+                                   [&](const string&, double, double) {
+        changes++;
+    });
+
+    SP1.DecreaseResource("Sugar", 10);
+    SP1.DecreaseResource("Sugar", 10);
+    SP1.IncreaseResource("Powder", 1);
+    SP1.IncreaseResource("Oxygen", 1);
+    SP1.Unwatch(watchId);
+    SP1.IncreaseResource("Water", 1);
+
+    // A watcher that removes itself and adds another during a notification
+    int once = 0, late = 0, selfId = 0;
+    selfId = SP1.WatchChanges({"Water"}, [&](const string&, double, double) {
+        once++;
+        SP1.Unwatch(selfId);
+        SP1.WatchChanges({"Water"}, [&](const string&, double, double) {
+            late++;
+        });
+    });
+    SP1.IncreaseResource("Water", 1);
+    SP1.IncreaseResource("Water", 1);
+
+    // Assignment tells the watchers about the quantities it changes
+    stockpile SP2;
+    double cookies = -1;
+    SP2.WatchChanges({"Cookie"}, [&](const string&, double, double after) {
+        cookies = after;
+    });
+    stockpile bakery;
+    bakery.IncreaseResource("Cookie", 2);
+    SP2 = bakery;
+
+    if (lowSugar == 1 && changes == 1 && once == 1 && late == 1 &&
+        SP1.QueryQuantity("Sugar") == 24 && cookies == 2) {
+        cout << "\nTest of stockpile watchers passed.\n";
+    }
+}
+
+
+void testStockpileReport() {
+    cout << "\n----------TEST STOCKPILE REPORTS----------\n";
+
+    stockpile SP1 = createStockpile1();
+    reportoptions page;
+    page.sorted = true;
+    page.limit = 2;
+
+    int pages = 0;
+    do {
+        cout << "\nPage " << ++pages << ":\n";
+        page.after = SP1.Report(cout, page);
+    } while (!page.after.empty());
+
+    reportoptions top;
+    top.topK = 2;
+    cout << "\nThe two largest quantities are:\n";
+    SP1.Report(cout, top);
+
+    if (pages == 3) {
+        cout << "\nTest of stockpile reports passed.\n";
+    }
+}
+
+
+void testFrozenStockpile() {
+    cout << "\n----------TEST FROZEN STOCKPILE----------\n";
+
+    stockpile SP1 = createStockpile1();
+    SP1.Freeze();
+    SP1.IncreaseResource("Water", 2);
+    SP1.DecreaseResource("Sugar", 4);
+
+    bool rejected = false;
+    try {
+        SP1.IncreaseResource("Cookie", 1);
+    }
+    catch (const out_of_range& e) {
+        cout << "\nException caught: " << e.what() << endl;
+        rejected = true;
+    }
+
+    cout << "\nThe frozen stockpile includes resources:\n"
+         << SP1.QueryResources();
+
+    SP1.Thaw();
+    SP1.IncreaseResource("Cookie", 1);
+
+    // A larger catalog keeps every quantity through the freeze
+    stockpile SP2;
+    const int catalogSize = 100000;
+    for (int i = 0; i < catalogSize; i++) {
+        SP2.IncreaseResource("Material" + to_string(i), i);
+    }
+    SP2.Freeze();
+    bool kept = SP2.QueryFrozen() &&
+                SP2.QueryQuantity("Material" + to_string(catalogSize)) == -1;
+    for (int i = 0; i < catalogSize && kept; i++) {
+        kept = SP2.QueryQuantity("Material" + to_string(i)) == i;
+    }
+
+    if (rejected && kept && SP1.QueryQuantity("Water") == 3 &&
+        SP1.QueryQuantity("Sugar") == 20 && SP1.QueryQuantity("Cookie") == 1
+        && SP1.QueryQuantity("Apple") == -1) {
+        cout << "\nTest of frozen stockpile passed.\n";
+    }
+}
+
+
+void testFixedStockpile() {
+    cout << "\n----------TEST FIXED STOCKPILE AND FORMULA----------\n";
+
+    static constexpr fixedformula<material, 2, 1> makeWater(
+            {{{material::Oxygen, 2}, {material::Hydrogen, 1}}},
+            {{{material::Water, 1}}});
+    static constexpr fixedformula<material, 3, 1> makeCookie(
+            {{{material::Water, 3}, {material::Powder, 3},
+              {material::Sugar, 1}}},
+            {{{material::Cookie, 1}}});
+
+    fixedstockpile<material> SP1;
+    SP1.IncreaseResource(material::Oxygen, 59);
+    SP1.IncreaseResource(material::Hydrogen, 67.6);
+    SP1.IncreaseResource(material::Powder, 17.1);
+    SP1.IncreaseResource(material::Sugar, 24);
+
+    fixedformula<material, 2, 1> water = makeWater;
+    fixedformula<material, 3, 1> cookie = makeCookie;
+    mt19937 gen(5011);
+
+    for (int i = 0; i < 10; i++) {
+        water.Apply(SP1, gen);
+    }
+
+    bool cookieApplied = false;
+    if (cookie.CheckMaterial(SP1)) {
+        cookie.Apply(SP1, gen);
+        cookieApplied = true;
+    }
+
+    cout << "\nWater in the fixed stockpile: "
+         << SP1.QueryQuantity(material::Water)
+         << "\nCookies in the fixed stockpile: "
+         << SP1.QueryQuantity(material::Cookie) << "\n";
+
+    if (cookieApplied == (SP1.QueryQuantity(material::Water) >= 3) &&
+        !makeWater.CheckMaterial(fixedstockpile<material>())) {
+        cout << "\nTest of fixed stockpile and formula passed.\n";
+    }
+}
+
+
+void testRecipeDSL() {
+    cout << "\n----------TEST COMPILE-TIME RECIPES----------\n";
+
+    static constexpr auto water = MakeRecipe({{"Oxygen", 2},
+                                              {"Hydrogen", 1}},
+                                             {{"Water", 1}});
+    static constexpr auto cookie = MakeRecipe({{"Water", 3}, {"Powder", 3},
+                                               {"Sugar", 1}},
+                                              {{"Cookie", 1}});
+    static constexpr auto cookiePlan = MakePlan(water, cookie);
+    static_assert(cookiePlan.QuerySize() == 2, "The plan has two steps.");
+
+    executableplan EP1 = cookiePlan.ToExecutablePlan();
+    executableplan EP2(createNewFormulaArray1(), 2);
+
+    cout << "\nThe plan declared at compile time is:\n"
+         << EP1.DisplayFormula();
+
+    if (EP1 == EP2) {
+        cout << "\nTest of compile-time recipes passed.\n";
+    }
+}
+
+void testContentHashing() {
+    cout << "\n----------TEST CONTENT HASHING----------\n";
+
+    bool passed = createNewFormula1().QueryRecipeHash() ==
+                  createNewFormula1().QueryRecipeHash() &&
+                  createNewFormula1().QueryRecipeHash() !=
+                  createNewFormula2().QueryRecipeHash();
+
+    // The same Formulas in a different order hash apart
+    plan P1, P2;
+    P1.Add(createNewFormula1());
+    P1.Add(createNewFormula2());
+    P2.Add(createNewFormula2());
+    P2.Add(createNewFormula1());
+    passed = passed && P1.QueryHash() != P2.QueryHash() && P1 != P2;
+
+    // Add, Remove and Replace keep the rolling hash up to date
+    P2.Replace(createNewFormula1(), 0);
+    P2.Replace(createNewFormula2(), 1);
+    passed = passed && P1.QueryHash() == P2.QueryHash() && P1 == P2;
+    P2.Remove();
+    P2.Add(createNewFormula3());
+    passed = passed && P1.QueryHash() != P2.QueryHash();
+    P2.Remove();
+    P2.Add(createNewFormula2());
+    passed = passed && P1.QueryHash() == P2.QueryHash() && P1 == P2;
+
+    unordered_set<plan> plans;
+    plans.insert(P1);
+    plans.insert(P2);
+    unordered_set<formula> formulas;
+    formulas.insert(createNewFormula1());
+    formulas.insert(createNewFormula1());
+    formulas.insert(createNewFormula3());
+    passed = passed && plans.size() == 1 && formulas.size() == 2;
+
+    cout << "\nThe Plan hash is " << P1.QueryHash() << ".\n";
+    if (passed) {
+        cout << "\nTest of content hashing passed.\n";
+    }
+}
+
+void testMaterialIndex() {
+    cout << "\n----------TEST MATERIAL INDEX----------\n";
+
+    recipecatalog catalog;
+    int waterId = catalog.Add(createNewFormula1());
+    int cookieId = catalog.Add(createNewFormula2());
+    catalog.Add(createNewFormula3());
+
+    bool passed = catalog.QueryProducers("Water") == vector<int>{waterId} &&
+                  catalog.QueryConsumers("Water") == vector<int>{cookieId} &&
+                  catalog.QueryProducers("Unobtainium").empty();
+    catalog.Remove(waterId);
+    passed = passed && catalog.QueryProducers("Water").empty() &&
+             catalog.QuerySize() == 2 && !catalog.QueryContains(waterId);
+
+    // The index of a Plan follows its edits
+    plan P1(createNewFormulaArray1(), 2);
+    P1.EnableMaterialIndex();
+    passed = passed && P1.QueryConsumers("Sugar") == vector<int>{1};
+    P1.Replace(createNewFormula1(), 1);
+    passed = passed && P1.QueryConsumers("Sugar").empty() &&
+             P1.QueryProducers("Water").size() == 2;
+    P1.Remove();
+    P1.Add(createNewFormula2());
+    passed = passed && P1.QueryConsumers("Sugar") == vector<int>{1} &&
+             P1.QueryProducers("Water") == vector<int>{0};
+
+    plan P2 = P1;
+    P2.Remove();
+    passed = passed && P1.QueryConsumers("Sugar") == vector<int>{1} &&
+             P2.QueryConsumers("Sugar").empty();
+
+    const formula& cookie = P1.QueryFormula(P1.QueryConsumers("Sugar")[0]);
+    cout << "\nThe step that consumes Sugar makes "
+         << cookie.QueryOutputNumber(0) << " "
+         << cookie.QueryOutputMaterial(0) << ".\n";
+    if (passed) {
+        cout << "\nTest of material index passed.\n";
+    }
+}
+
+void testCraftabilityIndex() {
+    cout << "\n----------TEST CRAFTABILITY INDEX----------\n";
+
+    recipecatalog catalog;
+    int waterId = catalog.Add(createNewFormula1());
+    int cookieId = catalog.Add(createNewFormula2());
+    int riceId = catalog.Add(createNewFormula3());
+    stockpile S1 = createStockpile1();
+    craftabilityindex craftable(catalog, S1);
+
+    bool passed = craftable.QueryCraftable(waterId) == 29 &&
+                  craftable.QueryCraftable(cookieId) == 0 &&
+                  craftable.QueryCraftable(riceId) == 0;
+
+    S1.IncreaseResource("Water", 30);
+    S1.DecreaseResource("Oxygen", 50);
+    passed = passed && craftable.QueryCraftable(waterId) == 4 &&
+             craftable.QueryCraftable(cookieId) == 5;
+
+    vector<pair<int, long long>> top = craftable.QueryTopK(2);
+    passed = passed && top.size() == 2 && top[0].first == cookieId &&
+             top[1].first == waterId;
+
+    craftable.Untrack(cookieId);
+    passed = passed && craftable.QueryTopK(1)[0].first == waterId;
+
+    // Sugar that is only needed, not used up, does not limit the Syrup
+    string* syrupInputs = new string[2]{"Sugar", "Oxygen"};
+    int* syrupNumbers = new int[2]{0, 2};
+    string* syrupOutputs = new string[1]{"Syrup"};
+    int* syrupYield = new int[1]{1};
+    int syrupId = catalog.Add(formula(syrupInputs, syrupNumbers, 2,
+                                      syrupOutputs, syrupYield, 1));
+    craftable.Track(syrupId);
+    passed = passed && craftable.QueryCraftable(syrupId) == 4;
+
+    cout << "\nThe most craftable recipe can be crafted "
+         << top[0].second << " times.\n";
+    if (passed) {
+        cout << "\nTest of craftability index passed.\n";
+    }
+}
+
+void testDeepCraftability() {
+    cout << "\n----------TEST DEEP CRAFTABILITY----------\n";
+
+    recipecatalog catalog;
+    catalog.Add(createNewFormula1());
+    catalog.Add(createNewFormula2());
+    stockpile S1 = createStockpile1();
+
+    // Cookies need Water that has to be crafted first
+    craftabilitysolver nominal(catalog);
+    bool passed = nominal.QueryMaxProducible("Water", S1) == 30 &&
+                  nominal.QueryMaxProducible("Cookie", S1) == 5;
+    craftabilitysolver expected(catalog, yieldmode::Expected);
+    passed = passed && expected.QueryMaxProducible("Water", S1) == 19;
+
+    // A cycle back to Oxygen is cut instead of looping forever
+    static constexpr auto electrolysis = MakeRecipe({{"Water", 1}},
+                                                    {{"Oxygen", 1}});
+    catalog.Add(electrolysis.ToFormula());
+    passed = passed && nominal.QueryMaxProducible("Cookie", S1) == 5;
+
+    vector<string> targets;
+    for (int i = 0; i < 1000; i++) {
+        targets.push_back(i % 2 == 0 ? "Cookie" : "Water");
+    }
+    vector<long long> counts = nominal.QueryMaxProducible(targets, S1, 4);
+    for (size_t i = 0; i < counts.size(); i++) {
+        passed = passed && counts[i] ==
+                 nominal.QueryMaxProducible(targets[i % 2], S1);
+    }
+
+    // Only the best single recipe counts, not Water from melting Ice too
+    static constexpr auto melting = MakeRecipe({{"Ice", 1}}, {{"Water", 1}});
+    catalog.Add(melting.ToFormula());
+    S1.IncreaseResource("Ice", 5);
+    passed = passed && nominal.QueryMaxProducible("Water", S1) == 30;
+
+    // A long recipe chain is solved without recursion
+    recipecatalog chain;
+    const int depth = 10000;
+    for (int i = 0; i < depth; i++) {
+        string* inputMat = new string[1]{"Link" + to_string(i + 1)};
+        string* outputMat = new string[1]{"Link" + to_string(i)};
+        chain.Add(formula(inputMat, new int[1]{1}, 1,
+                          outputMat, new int[1]{1}, 1));
+    }
+    stockpile S2;
+    S2.IncreaseResource("Link" + to_string(depth), 3);
+    craftabilitysolver deep(chain);
+    passed = passed && deep.QueryMaxProducible("Link0", S2) == 3;
+
+    cout << "\nAt most " << counts[0] << " Cookies can be made.\n";
+    if (passed) {
+        cout << "\nTest of deep craftability passed.\n";
+    }
+}
+
+void testProductionPlanner() {
+    cout << "\n----------TEST PRODUCTION PLANNER----------\n";
+
+    recipecatalog catalog;
+    catalog.Add(createNewFormula1());
+    catalog.Add(createNewFormula2());
+    catalog.Add(createNewFormula3());
+    stockpile S1 = createStockpile1();
+    stockpile bill;
+    bill.IncreaseResource("Cookie", 2);
+    bill.IncreaseResource("Water", 2);
+
+    // Water is demanded by the bill and by the Cookies, and planned once
+    productionplanner planner(catalog);
+    executableplan EP1 = planner.Plan(bill, S1);
+    bool passed = EP1.QuerySize() == 9 &&
+                  planner.QueryDemand("Water") == 8 &&
+                  planner.QueryCrafts("Water") == 7 &&
+                  planner.QueryCrafts("Cookie") == 2 &&
+                  planner.QueryDemand("Oxygen") == 14 &&
+                  EP1.QueryFormula(0) == createNewFormula1() &&
+                  EP1.QueryFormula(8) == createNewFormula2();
+
+    // Rice needs Grain, which needs Rice
+    static constexpr auto milling = MakeRecipe({{"Rice", 1}},
+                                               {{"Grain", 1}});
+    catalog.Add(milling.ToFormula());
+    stockpile riceBill;
+    riceBill.IncreaseResource("Rice", 1);
+    try {
+        planner.Plan(riceBill, S1);
+        passed = false;
+    }
+    catch (runtime_error& e) {
+        cout << "\n" << e.what() << "\n";
+    }
+
+    // The cycle is reported even when Rice in stock covers the bill
+    stockpile S2 = createStockpile1();
+    S2.IncreaseResource("Rice", 5);
+    try {
+        planner.Plan(riceBill, S2);
+        passed = false;
+    }
+    catch (runtime_error& e) {
+        passed = passed && string(e.what()).find("cycle") != string::npos;
+    }
+
+    // Crafts that never roll carry no generator, so a long plan stays small
+    stockpile bulk;
+    bulk.IncreaseResource("Water", 200000);
+    stockpile plenty;
+    plenty.IncreaseResource("Oxygen", 400000);
+    plenty.IncreaseResource("Hydrogen", 200000);
+    passed = passed && planner.Plan(bulk, plenty).QuerySize() == 200000;
+
+    // A seeded Formula hands its generator on; the source copies unseeded
+    formula seeded = createNewFormula1();
+    seeded.Seed(2026);
+    formula twin(seeded);
+    formula moved(std::move(seeded));
+    formula leftover(seeded);
+    leftover = seeded;
+    passed = passed && moved.Apply() == twin.Apply() &&
+             leftover.QueryInputSize() == 0;
+
+    cout << "\nThe plan for the bill has " << EP1.QuerySize()
+         << " steps.\n";
+    if (passed) {
+        cout << "\nTest of production planner passed.\n";
+    }
+}
+
+void testRecipeMatrix() {
+    cout << "\n----------TEST RECIPE MATRIX----------\n";
+
+    recipecatalog catalog;
+    catalog.Add(createNewFormula1());
+    catalog.Add(createNewFormula2());
+    recipematrix matrix(catalog, yieldmode::Nominal, true);
+    stockpile S1 = createStockpile1();
+
+    // Craft 10 Water, then 3 Cookies from it, consuming the inputs
+    matrix.Apply(vector<double>{10, 0}, S1);
+    matrix.Apply(vector<double>{0, 3}, S1);
+    bool passed = S1.QueryQuantity("Oxygen") == 39 &&
+                  S1.QueryQuantity("Water") == 2 &&
+                  S1.QueryQuantity("Cookie") == 3;
+
+    // 4 more Cookies need 12 Water, and nothing changes
+    try {
+        matrix.Apply(vector<double>{0, 4}, S1);
+        passed = false;
+    }
+    catch (runtime_error& e) {
+        passed = passed && S1.QueryQuantity("Cookie") == 3;
+    }
+
+    // As with ExecutablePlan::Apply, checked inputs are not used up
+    recipematrix checked(catalog);
+    stockpile S2 = createStockpile1();
+    checked.Apply(vector<double>{10, 0}, S2);
+    checked.Apply(vector<double>{0, 4}, S2);
+    passed = passed && S2.QueryQuantity("Oxygen") == 59 &&
+             S2.QueryQuantity("Water") == 11 &&
+             S2.QueryQuantity("Cookie") == 4 &&
+             !checked.CheckFeasible(vector<double>{1, 1},
+                                    vector<double>(
+                                            checked.QueryMaterialCount(), 2));
+
+    // A large catalog gives the same result on several threads
+    recipecatalog large;
+    for (int i = 0; i < 20000; i++) {
+        string* inputMat = new string[2]{"Ore" + to_string(i % 500),
+                                         "Part" + to_string(i % 1500)};
+        int* inputNum = new int[2]{1 + i % 3, 1};
+        string* outputMat = new string[1]{"Part" + to_string(i % 2000)};
+        int* outputNum = new int[1]{1 + i % 2};
+        large.Add(formula(inputMat, inputNum, 2, outputMat, outputNum, 1));
+    }
+    recipematrix largeMatrix(large);
+    vector<double> stock(largeMatrix.QueryMaterialCount(), 1000);
+    vector<double> counts(largeMatrix.QueryRecipeCount(), 1);
+    vector<double> serial = stock;
+    largeMatrix.Apply(counts, serial, 1);
+    largeMatrix.Apply(counts, stock, 4);
+    passed = passed && serial == stock;
+
+    cout << "\nThe large matrix has " << largeMatrix.QueryValues().size()
+         << " entries.\n";
+    if (passed) {
+        cout << "\nTest of recipe matrix passed.\n";
+    }
+}
+
+void testThroughputSolver() {
+    cout << "\n----------TEST THROUGHPUT SOLVER----------\n";
+
+    recipecatalog catalog;
+    int waterId = catalog.Add(createNewFormula1());
+    int cookieId = catalog.Add(createNewFormula2());
+    catalog.Add(createNewFormula3());
+    stockpile S1 = createStockpile1();
+
+    // Powder limits the Cookies to 17.1 / 3, and at least 15.8 Water must
+    // be crafted for them
+    throughputsolver solver(catalog, yieldmode::Nominal);
+    throughputresult best = solver.Maximize("Cookie", S1);
+    bool passed = fabs(best.objective - 5.7) < 1e-6 &&
+                  best.integerObjective == 5;
+    for (const pair<int, long long>& craft : best.integerCrafts) {
+        passed = passed && (craft.first != waterId || craft.second >= 14);
+        passed = passed && (craft.first != cookieId || craft.second == 5);
+    }
+
+    // More Powder only needs a few dual simplex pivots
+    S1.IncreaseResource("Powder", 3);
+    throughputresult warm = solver.Resolve(S1);
+    passed = passed && fabs(warm.objective - 6.7) < 1e-6 &&
+             warm.integerObjective == 6 && warm.iterations <= 2;
+
+    // With expected yields, Oxygen allows 29.5 crafts of Water
+    throughputsolver expected(catalog);
+    throughputresult water = expected.Maximize("Water", S1);
+    passed = passed && fabs(water.objective - 29.5 *
+             catalog.QueryFormula(waterId).QueryExpectedYield()) < 1e-6;
+
+    cout << "\nAt most " << best.objective << " Cookies, or "
+         << best.integerObjective << " whole ones, can be made.\n";
+    if (passed) {
+        cout << "\nTest of throughput solver passed.\n";
+    }
+}
+
+void testPlanOptimizer() {
+    cout << "\n----------TEST PLAN OPTIMIZER----------\n";
+
+    // Cookies placed before the Water they need run short of it
+    plan P1;
+    for (int round = 0; round < 3; round++) {
+        P1.Add(createNewFormula2());
+        for (int i = 0; round < 2 && i < 6; i++) {
+            P1.Add(createNewFormula1());
+        }
+    }
+    stockpile S1 = createStockpile1();
+    vector<int> original;
+    for (int s = 0; s < P1.QuerySize(); s++) {
+        original.push_back(s);
+    }
+
+    planoptimizer optimizer(P1, S1);
+    reorderresult before = optimizer.Evaluate(original);
+    reorderresult best = optimizer.Optimize();
+    bool passed = best.optimal && best.value > before.value &&
+                  optimizer.Evaluate(best.order).value == best.value;
+    plan P2 = planoptimizer::Reorder(P1, best.order);
+    passed = passed && P2.QuerySize() == P1.QuerySize() &&
+             P2.QueryFormula(P2.QuerySize() - 1) == createNewFormula2();
+
+    // A long plan falls back to the time-limited heuristic
+    plan P3;
+    for (int i = 0; i < 40; i++) {
+        if (i % 5 == 0) {
+            P3.Add(createNewFormula2());
+        }
+        else {
+            P3.Add(createNewFormula1());
+        }
+    }
+    reorderoptions quick;
+    quick.timeLimitMillis = 50;
+    planoptimizer heuristic(P3, S1, quick);
+    vector<int> identity;
+    for (int s = 0; s < P3.QuerySize(); s++) {
+        identity.push_back(s);
+    }
+    reorderresult improved = heuristic.Optimize();
+    passed = passed && !improved.optimal &&
+             improved.value >= heuristic.Evaluate(identity).value &&
+             heuristic.Evaluate(improved.order).value == improved.value;
+
+    cout << "\nReordering raises the expected Cookies from " << before.value
+         << " to " << best.value << ".\n";
+    if (passed) {
+        cout << "\nTest of plan optimizer passed.\n";
+    }
+}
+
+void testFormulaFusion() {
+    cout << "\n----------TEST FORMULA FUSION----------\n";
+
+    // Three Water made in one step and used up by the Cookie
+    static constexpr auto water = MakeRecipe({{"Oxygen", 6},
+                                              {"Hydrogen", 3}},
+                                             {{"Water", 3}});
+    executableplan EP1;
+    EP1.Add(water.ToFormula());
+    EP1.Add(createNewFormula2());
+    executableplan EP2 = planfusion::Fuse(EP1);
+
+    const formula& fused = EP2.QueryFormula(0);
+    bool passed = EP2.QuerySize() == 1 && fused.QueryFused() &&
+                  fused.QueryInputSize() == 4 &&
+                  fused.QueryInputMaterial(0) == "Oxygen" &&
+                  fused.QueryInputNumber(0) == 6 &&
+                  fused.QueryOutputMaterial(0) == "Cookie";
+    double chained = EP1.QueryFormula(0).QueryExpectedYield() *
+                     EP1.QueryFormula(1).QueryExpectedYield();
+    passed = passed && fabs(fused.QueryExpectedYield() - chained) < 1e-9;
+
+    // One draw decides the whole chain
+    shared_ptr<stockpile> S1 = make_shared<stockpile>(createStockpile1());
+    EP2.Apply(S1);
+    vector<int> tiers = EP2.QueryFormula(0).QueryFusedTiers();
+    double cookies = 0;
+    S1->ForEachResource([&cookies](const string& name, double quantity) {
+        if (name == "Cookie") {
+            cookies = quantity;
+        }
+    });
+    passed = passed && tiers.size() == 2 && tiers[0] >= 0 &&
+             (tiers[0] == 0) == (tiers[1] == -1) &&
+             (cookies > 0) == (tiers[1] > 0);
+
+    // The chained Water never reaches the Stockpile, and a fused Apply
+    // reports its outcome like any other Formula
+    double leftWater = 0;
+    S1->ForEachResource([&leftWater](const string& name, double quantity) {
+        if (name == "Water") {
+            leftWater = quantity;
+        }
+    });
+    formula probe(fused);
+    string outcome = probe.Apply();
+    passed = passed && leftWater == 1.3 &&
+             outcome.find('\n') == string::npos;
+
+    // The steps come back for an audit
+    executableplan EP3 = planfusion::Expand(EP2);
+    passed = passed && EP3.QuerySize() == 2 &&
+             EP3.QueryFormula(0).QueryRecipeHash() ==
+             EP1.QueryFormula(0).QueryRecipeHash() &&
+             EP3.QueryFormula(1).QueryRecipeHash() ==
+             EP1.QueryFormula(1).QueryRecipeHash();
+
+    // Water that a later step also needs is not fused away
+    plan P1;
+    P1.Add(water.ToFormula());
+    P1.Add(createNewFormula2());
+    P1.Add(createNewFormula2());
+    passed = passed && planfusion::Fuse(P1).QuerySize() == 3;
+
+    cout << "\nThe fused Cookie step yields " << fused.QueryExpectedYield()
+         << " Cookies on average.\n";
+    if (passed) {
+        cout << "\nTest of formula fusion passed.\n";
+    }
+}
+
+void testReplanner() {
+    cout << "\n----------TEST REPLANNER----------\n";
+
+    recipecatalog catalog;
+    catalog.Add(createNewFormula1());
+    catalog.Add(createNewFormula2());
+    stockpile bill;
+    bill.IncreaseResource("Cookie", 1);
+    productionplanner planner(catalog);
+    executableplan EP1 = planner.Plan(bill, createStockpile1());
+    executableplan EP2 = EP1;
+
+    // The first Water failed, so one more Water goes before the Cookie
+    EP1.ApplyCurrentStep();
+    replanner repairer(catalog);
+    int inserted = repairer.Repair(EP1, createStockpile1());
+    bool passed = inserted == 1 && EP1.QuerySize() == 4 &&
+                  EP1.QueryCurrentIndex() == 1 &&
+                  EP1.QueryFormula(2) == createNewFormula1() &&
+                  EP1.QueryFormula(3) == createNewFormula2() &&
+                  repairer.Repair(EP1, createStockpile1()) == 0;
+
+    // Applying a step does not use up its Oxygen, so Water can be crafted
+    // again from the same 2 Oxygen
+    static constexpr auto melting = MakeRecipe({{"Ice", 1}},
+                                               {{"Water", 1}});
+    catalog.Add(melting.ToFormula());
+    stockpile S1;
+    S1.IncreaseResource("Oxygen", 2);
+    S1.IncreaseResource("Hydrogen", 5);
+    S1.IncreaseResource("Powder", 3);
+    S1.IncreaseResource("Sugar", 1);
+    S1.IncreaseResource("Ice", 5);
+    EP2.ApplyCurrentStep();
+    executableplan EP3 = EP2;
+    passed = passed && repairer.Repair(EP3, S1) == 2 &&
+             EP3.QuerySize() == 5 &&
+             EP3.QueryFormula(2) == createNewFormula1() &&
+             EP3.QueryFormula(3) == createNewFormula1();
+
+    // When the steps consume their inputs, the Water comes from Ice instead
+    passed = passed && repairer.Repair(EP2, S1, true) == 2 &&
+             EP2.QuerySize() == 5 &&
+             EP2.QueryFormula(2) == melting.ToFormula() &&
+             EP2.QueryFormula(3) == melting.ToFormula() &&
+             EP2.QueryFormula(4) == createNewFormula2();
+
+    // Missing Sugar cannot be crafted, and the plan stays as it was
+    S1.DecreaseResource("Sugar", 1);
+    unsigned long long hash = EP2.QueryHash();
+    try {
+        repairer.Repair(EP2, S1, true);
+        passed = false;
+    }
+    catch (runtime_error& e) {
+        cout << "\n" << e.what() << "\n";
+    }
+    passed = passed && EP2.QueryHash() == hash && EP2.QuerySize() == 5;
+
+    cout << "\nThe repaired plan has " << EP1.QuerySize() << " steps.\n";
+    if (passed) {
+        cout << "\nTest of replanner passed.\n";
+    }
+}
+
+void testParallelExecution() {
+    cout << "\n----------TEST PARALLEL EXECUTION----------\n";
+
+    // Water and Rice are independent; each Cookie waits for its Water
+    executableplan EP1;
+    for (int round = 0; round < 60; round++) {
+        EP1.Add(createNewFormula1());
+        EP1.Add(createNewFormula1());
+        EP1.Add(createNewFormula1());
+        EP1.Add(createNewFormula3());
+        EP1.Add(createNewFormula2());
+    }
+    plandag dag(EP1);
+    const vector<int>& join = dag.QueryPredecessors(4);
+    bool passed = dag.QuerySize() == 300 && join.size() == 1 &&
+                  dag.QueryJoin(join[0]) &&
+                  dag.QueryPredecessors(join[0]) == vector<int>{0, 1, 2} &&
+                  dag.QueryPredecessors(3).empty() &&
+                  dag.QuerySuccessors(3).empty() &&
+                  dag.QuerySuccessors(4) == vector<int>{5, 6, 7};
+
+    // Steps that only add to the same Flour do not wait for each other
+    static constexpr auto grinding = MakeRecipe({{"Stone", 1}},
+                                                {{"Flour", 1}});
+    plan P1;
+    for (int i = 0; i < 4; i++) {
+        P1.Add(grinding.ToFormula());
+    }
+    passed = passed && plandag(P1).QueryEdgeCount() == 0;
+
+    // Many Flour writers then many readers meet in one join
+    static constexpr auto baking = MakeRecipe({{"Flour", 1}},
+                                              {{"Bread", 1}});
+    plan P2;
+    for (int i = 0; i < 5000; i++) {
+        P2.Add(grinding.ToFormula());
+    }
+    for (int i = 0; i < 5000; i++) {
+        P2.Add(baking.ToFormula());
+    }
+    plandag bakery(P2);
+    passed = passed && bakery.QueryNodeCount() == 10001 &&
+             bakery.QueryEdgeCount() == 10000;
+
+    auto snapshot = [](const stockpile& target) {
+        map<string, double> quantities;
+        target.ForEachResource([&](const string& name, double quantity) {
+            quantities[name] = quantity;
+        });
+        return quantities;
+    };
+
+    // The same seeds give the same Stockpile either way
+    stockpile initial = createStockpile1();
+    initial.IncreaseResource("Water", 10);
+    initial.IncreaseResource("Grain", 100);
+    EP1.Seed(2026);
+    executableplan EP2 = EP1;
+    shared_ptr<stockpile> S1 = make_shared<stockpile>(initial);
+    shared_ptr<stockpile> S2 = make_shared<stockpile>(initial);
+    for (int s = 0; s < EP1.QuerySize(); s++) {
+        EP1.Apply(S1);
+    }
+    EP2.ApplyParallel(S2, 4);
+    passed = passed && snapshot(*S1) == snapshot(*S2) && EP1 == EP2;
+
+    // Without Grain both stop at the first Rice, after the same steps
+    stockpile noGrain = createStockpile1();
+    noGrain.IncreaseResource("Water", 10);
+    EP1.Reset();
+    EP1.Seed(7);
+    EP2 = EP1;
+    S1 = make_shared<stockpile>(noGrain);
+    S2 = make_shared<stockpile>(noGrain);
+    bool stopped = false;
+    try {
+        while (true) {
+            EP1.Apply(S1);
+        }
+    }
+    catch (runtime_error& e) {
+        stopped = true;
+    }
+    try {
+        EP2.ApplyParallel(S2, 4);
+        passed = false;
+    }
+    catch (runtime_error& e) {
+        cout << "\n" << e.what() << "\n";
+    }
+    passed = passed && stopped && EP2.QueryCurrentIndex() == 3 &&
+             EP1.QueryCurrentIndex() == 3 &&
+             snapshot(*S1) == snapshot(*S2) && EP1 == EP2;
+
+    cout << "\nThe plan has " << dag.QueryEdgeCount()
+         << " dependencies between " << dag.QuerySize() << " steps.\n";
+    if (passed) {
+        cout << "\nTest of parallel execution passed.\n";
+    }
+}
+
+void testBottleneckAnalysis() {
+    cout << "\n----------TEST BOTTLENECK ANALYSIS----------\n";
+
+    // Two Waters feed the Cookie; the Rice chain lacks Grain
+    static constexpr auto porridge = MakeRecipe({{"Rice", 2}},
+                                                {{"Porridge", 1}});
+    plan P1;
+    P1.Add(createNewFormula1());
+    P1.Add(createNewFormula1());
+    P1.Add(createNewFormula3());
+    P1.Add(porridge.ToFormula());
+    P1.Add(createNewFormula2());
+    stockpile S1 = createStockpile1();
+
+    bottleneckanalyzer analyzer(P1, S1);
+    const vector<materialshortage>& shortages = analyzer.QueryShortages();
+    bool passed = analyzer.QueryMakespan() == 2 &&
+                  analyzer.QueryCriticalPath() == vector<int>{2, 3} &&
+                  analyzer.QuerySlack(0) == 0 &&
+                  analyzer.QuerySlack(1) == 0 &&
+                  analyzer.QuerySlack(4) == 0 &&
+                  analyzer.QueryEarliestStart(3) == 1 &&
+                  analyzer.QueryEarliestStart(4) == 1 &&
+                  analyzer.QueryBlocked(2) && analyzer.QueryBlocked(3) &&
+                  !analyzer.QueryBlocked(4) && shortages.size() == 1 &&
+                  shortages[0].material == "Grain" &&
+                  shortages[0].blockedSteps == 2 &&
+                  shortages[0].deficit == 1;
+
+    // A slow Rice step gives the Water and Cookie steps slack
+    bottleneckanalyzer timed(P1, S1, {1, 1, 5, 1, 1});
+    passed = passed && timed.QueryMakespan() == 6 &&
+             timed.QueryCriticalPath() == vector<int>{2, 3} &&
+             timed.QuerySlack(0) == 4 && timed.QuerySlack(4) == 4;
+
+    // Bread lacks both Grain and Salt, and so does the Toast made from it
+    static constexpr auto baking = MakeRecipe({{"Grain", 1}, {"Salt", 1}},
+                                              {{"Bread", 1}});
+    static constexpr auto toasting = MakeRecipe({{"Bread", 1}},
+                                                {{"Toast", 1}});
+    plan P2;
+    P2.Add(baking.ToFormula());
+    P2.Add(toasting.ToFormula());
+    bottleneckanalyzer bakery(P2, S1);
+    const vector<materialshortage>& missing = bakery.QueryShortages();
+    passed = passed && missing.size() == 2 &&
+             missing[0].material == "Grain" && missing[0].blockedSteps == 2 &&
+             missing[1].material == "Salt" && missing[1].blockedSteps == 2 &&
+             missing[1].deficit == 1;
+
+    // Steps that only add to the same Flour all run at once
+    static constexpr auto grinding = MakeRecipe({{"Stone", 1}},
+                                                {{"Flour", 1}});
+    plan P3;
+    for (int i = 0; i < 4; i++) {
+        P3.Add(grinding.ToFormula());
+    }
+    bottleneckanalyzer mill(P3, S1);
+    passed = passed && mill.QueryMakespan() == 1 &&
+             mill.QueryCriticalPath().size() == 1 && mill.QuerySlack(3) == 0;
+
+    // Apply only checks the Water, so both boilers run unless consuming
+    static constexpr auto boiling = MakeRecipe({{"Water", 1}},
+                                               {{"Steam", 1}});
+    plan P5;
+    P5.Add(boiling.ToFormula());
+    P5.Add(boiling.ToFormula());
+    bottleneckanalyzer checked(P5, S1);
+    bottleneckanalyzer consumed(P5, S1, yieldmode::Nominal, true);
+    passed = passed && checked.QueryShortages().empty() &&
+             !checked.QueryBlocked(1) && consumed.QueryBlocked(1) &&
+             consumed.QueryShortages().size() == 1 &&
+             consumed.QueryShortages()[0].material == "Water" &&
+             fabs(consumed.QueryShortages()[0].deficit - 0.7) < 1e-9;
+
+    // A million steps, half grinding and half baking, take two units
+    static constexpr auto loaf = MakeRecipe({{"Flour", 1}},
+                                            {{"Bread", 1}});
+    plan P4;
+    for (int i = 0; i < 500000; i++) {
+        P4.Add(grinding.ToFormula());
+    }
+    for (int i = 0; i < 500000; i++) {
+        P4.Add(loaf.ToFormula());
+    }
+    stockpile quarry;
+    quarry.IncreaseResource("Stone", 500000);
+    bottleneckanalyzer mills(P4, quarry);
+    passed = passed && mills.QueryMakespan() == 2 &&
+             mills.QueryShortages().empty() &&
+             mills.QueryCriticalPath().size() == 2;
+
+    cout << "\nGrain blocks " << shortages[0].blockedSteps
+         << " steps; the plan takes " << analyzer.QueryMakespan()
+         << " units.\n";
+    if (passed) {
+        cout << "\nTest of bottleneck analysis passed.\n";
+    }
+}
+
+void testStationScheduler() {
+    cout << "\n----------TEST STATION SCHEDULER----------\n";
+
+    // Water feeds the Cookie; two Rice feed the Porridge
+    static constexpr auto porridge = MakeRecipe({{"Rice", 2}},
+                                                {{"Porridge", 1}});
+    plan P1;
+    P1.Add(createNewFormula1());
+    P1.Add(createNewFormula3());
+    P1.Add(createNewFormula3());
+    P1.Add(createNewFormula2());
+    P1.Add(porridge.ToFormula());
+    plandag dag(P1);
+
+    // Checks the dependencies and that no station runs two steps at once
+    auto valid = [&](const stationscheduler& scheduler) {
+        for (int s = 0; s < P1.QuerySize(); s++) {
+            const scheduledstep& step = scheduler.QueryStep(s);
+            vector<int> before = dag.QueryPredecessors(s);
+            for (size_t i = 0; i < before.size(); i++) {
+                int p = before[i];
+                if (dag.QueryJoin(p)) {
+                    const vector<int>& group = dag.QueryPredecessors(p);
+                    before.insert(before.end(), group.begin(), group.end());
+                }
+                else if (scheduler.QueryStep(p).finish > step.start) {
+                    return false;
+                }
+            }
+            for (int t = 0; t < s; t++) {
+                const scheduledstep& other = scheduler.QueryStep(t);
+                if (other.station == step.station &&
+                    other.start < step.finish && step.start < other.finish) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    stationscheduler single(P1, 1);
+    bool passed = single.Schedule() == 5 && valid(single);
+
+    // Five steps on two stations take at least 3 units, and get them
+    stationscheduler scheduler(P1, 2);
+    passed = passed && scheduler.Schedule() == 3 && valid(scheduler);
+
+    // Station 1 is slow at Rice, and the search still finds 3 units
+    scheduler.SetDuration(1, createNewFormula3(), 4);
+    scheduler.SetDuration(0, createNewFormula1(), 2);
+    scheduleoptions options;
+    options.iterations = 0;
+    double listed = scheduler.Schedule(options);
+    double improved = scheduler.Schedule();
+    passed = passed && improved <= listed && improved == 3 &&
+             valid(scheduler) &&
+             scheduler.QueryStationSteps(0).size() +
+             scheduler.QueryStationSteps(1).size() == 5;
+
+    // The executor runs the steps in the order they start
+    executableplan EP1 = scheduler.ToExecutablePlan();
+    vector<int> order = scheduler.QueryOrder();
+    passed = passed && EP1.QuerySize() == 5;
+    for (int s = 0; s < EP1.QuerySize(); s++) {
+        passed = passed && EP1.QueryFormula(s) == P1.QueryFormula(order[s]);
+    }
+
+    // Steps that only add to the same Flour spread over the stations
+    static constexpr auto grinding = MakeRecipe({{"Stone", 1}},
+                                                {{"Flour", 1}});
+    plan P2;
+    for (int i = 0; i < 4; i++) {
+        P2.Add(grinding.ToFormula());
+    }
+    stationscheduler oneMill(P2, 1);
+    stationscheduler fourMills(P2, 4);
+    passed = passed && oneMill.Schedule() == 4 && fourMills.Schedule() == 1;
+    for (int station = 0; station < 4; station++) {
+        passed = passed && fourMills.QueryStationSteps(station).size() == 1;
+    }
+
+    // Without a time limit the search repeats itself exactly
+    stationscheduler again(P1, 2);
+    again.SetDuration(1, createNewFormula3(), 4);
+    again.SetDuration(0, createNewFormula1(), 2);
+    again.Schedule();
+    passed = passed && again.QueryOrder() == scheduler.QueryOrder();
+    for (int s = 0; s < P1.QuerySize(); s++) {
+        passed = passed && again.QueryStep(s).station ==
+                           scheduler.QueryStep(s).station;
+    }
+
+    // Large groups of Flour writers and readers stay cheap to schedule
+    static constexpr auto baking = MakeRecipe({{"Flour", 1}},
+                                              {{"Bread", 1}});
+    plan P3;
+    for (int i = 0; i < 100000; i++) {
+        P3.Add(grinding.ToFormula());
+    }
+    for (int i = 0; i < 100000; i++) {
+        P3.Add(baking.ToFormula());
+    }
+    stationscheduler bakery(P3, 4);
+    scheduleoptions brief;
+    brief.iterations = 2;
+    passed = passed && bakery.Schedule(brief) == 50000;
+
+    cout << "\nTwo stations finish the plan in " << improved << " units.\n";
+    if (passed) {
+        cout << "\nTest of station scheduler passed.\n";
+    }
+}
@@ -0,0 +1,228 @@
+// AUTHOR:      Hongru He
+// FILENAME:    perfecthash.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "perfecthash.h"
+#include <stdexcept>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Names are hashed into about 3n / 4 buckets, and buckets are placed
+//      from the largest down. A bucket's pilot is the first value that moves all
+//      its hashes to free, distinct indices.
+// 2.   A bucket with one name takes the next free index directly. Its pilot
+//      stores that index with the DIRECT bit set, which avoids the long pilot
+//      searches at the end of a minimal table.
+// 3.   If a pilot search runs too long, the whole build restarts with
+//      another seed.
+
+static const unsigned int DIRECT = 0x80000000u;
+static const unsigned int MAXPILOT = 1u << 20;
+
+// Mix
+// Finalizes a 64-bit value, as in splitmix64.
+static unsigned long long Mix(unsigned long long value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
+
+// Reduce
+// Maps a 32-bit value onto the range 0 to bound - 1 without a division.
+static unsigned int Reduce(unsigned int value, unsigned int bound) {
+    return (unsigned int) (((unsigned long long) value * bound) >> 32);
+}
+
+// Default Constructor
+perfecthash::perfecthash() {
+    seed = 0;
+    bucketCount = 1;
+    pilots.assign(1, 0);
+}
+
+// Overloaded Constructor
+// Hashes every name once and retries the pilot search with new seeds until
+// it succeeds. The names usually live in separate allocations, so each is
+// prefetched a few names ahead of its hash.
+perfecthash::perfecthash(const vector<string_view>& names,
+                         vector<unsigned int>* positions) {
+    if (names.size() >= DIRECT) {
+        throw length_error("Too many names for a perfect hash.");
+    }
+
+    const size_t AHEAD = 8;
+    bucketCount = names.size() / 4 * 3 + 1;
+    vector<unsigned long long> hashes(names.size());
+    for (seed = 0x9e3779b97f4a7c15ull; ; seed = Mix(seed)) {
+        for (size_t i = 0; i < names.size(); i++) {
+            if (i + AHEAD < names.size()) {
+                __builtin_prefetch(names[i + AHEAD].data());
+            }
+            hashes[i] = Hash(names[i], seed);
+        }
+        if (TryBuild(hashes)) {
+            break;
+        }
+    }
+
+    if (positions != nullptr) {
+        positions->resize(names.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            unsigned int pilot = pilots[Bucket(hashes[i])];
+            (*positions)[i] = (pilot & DIRECT) ? (pilot & ~DIRECT) :
+                              Position(hashes[i], pilot);
+        }
+    }
+}
+
+// Hash a name with a seed
+// FNV-1a over the bytes, finalized so that every bit depends on every byte.
+unsigned long long perfecthash::Hash(string_view name,
+                                     unsigned long long hashSeed) {
+    unsigned long long hash = 14695981039346656037ull ^ hashSeed;
+    for (char c : name) {
+        hash ^= (unsigned char) c;
+        hash *= 1099511628211ull;
+    }
+    return Mix(hash);
+}
+
+// Get the bucket of a hash
+unsigned int perfecthash::Bucket(unsigned long long hash) const {
+    return Reduce((unsigned int) (hash >> 32), bucketCount);
+}
+
+// Get the index of a hash displaced by a pilot
+unsigned int perfecthash::Position(unsigned long long hash,
+                                   unsigned int pilot) const {
+    return Reduce((unsigned int) Mix(hash ^ (pilot * 0x9e3779b97f4a7c15ull)),
+                  (unsigned int) fingerprints.size());
+}
+
+// Try Build
+// Places the buckets from the largest to the smallest; returns false if a
+// bucket cannot be placed or two names share a hash.
+bool perfecthash::TryBuild(const vector<unsigned long long>& hashes) {
+    size_t count = hashes.size();
+    fingerprints.assign(count, 0);
+    pilots.assign(bucketCount, 0);
+
+    // Radix sort of the hashes by bucket, twelve bits per pass, so grouping
+    // them needs sequential passes only.
+    vector<unsigned long long> members(hashes);
+    vector<unsigned long long> buffer(count);
+    for (int shift = 0; shift < 32 && (bucketCount - 1) >> shift != 0;
+         shift += 12) {
+        vector<size_t> digitStart(4097, 0);
+        for (unsigned long long hash : members) {
+            digitStart[((Bucket(hash) >> shift) & 0xFFF) + 1]++;
+        }
+        for (int d = 0; d < 4096; d++) {
+            digitStart[d + 1] += digitStart[d];
+        }
+        for (unsigned long long hash : members) {
+            buffer[digitStart[(Bucket(hash) >> shift) & 0xFFF]++] = hash;
+        }
+        members.swap(buffer);
+    }
+    buffer.clear();
+    buffer.shrink_to_fit();
+
+    vector<unsigned int> start(bucketCount + 1, 0);
+    unsigned int largest = 0;
+    for (size_t i = 0, b = 0; b < bucketCount; b++) {
+        start[b] = (unsigned int) i;
+        while (i < count && Bucket(members[i]) == b) {
+            i++;
+        }
+        if (i - start[b] > largest) {
+            largest = (unsigned int) (i - start[b]);
+        }
+    }
+    start[bucketCount] = (unsigned int) count;
+
+    vector<unsigned int> sizeStart(largest + 2, 0);
+    for (unsigned int b = 0; b < bucketCount; b++) {
+        sizeStart[largest - (start[b + 1] - start[b]) + 1]++;
+    }
+    for (unsigned int s = 0; s <= largest; s++) {
+        sizeStart[s + 1] += sizeStart[s];
+    }
+    vector<unsigned int> order(bucketCount);
+    for (unsigned int b = 0; b < bucketCount; b++) {
+        order[sizeStart[largest - (start[b + 1] - start[b])]++] = b;
+    }
+
+    vector<bool> taken(count, false);
+    vector<unsigned int> positions(largest);
+    size_t nextFree = 0;
+
+    for (unsigned int b : order) {
+        unsigned int first = start[b], size = start[b + 1] - start[b];
+        if (size == 0) {
+            break;
+        }
+
+        if (size == 1) {
+            while (taken[nextFree]) {
+                nextFree++;
+            }
+            taken[nextFree] = true;
+            fingerprints[nextFree] = members[first];
+            pilots[b] = DIRECT | (unsigned int) nextFree;
+            continue;
+        }
+
+        unsigned int pilot = 0;
+        for (; pilot < MAXPILOT; pilot++) {
+            unsigned int placed = 0;
+            for (; placed < size; placed++) {
+                unsigned int position = Position(members[first + placed],
+                                                 pilot);
+                if (taken[position]) {
+                    break;
+                }
+                taken[position] = true;
+                positions[placed] = position;
+            }
+            if (placed == size) {
+                break;
+            }
+            for (unsigned int i = 0; i < placed; i++) {
+                taken[positions[i]] = false;
+            }
+        }
+        if (pilot == MAXPILOT) {
+            return false;
+        }
+
+        pilots[b] = pilot;
+        for (unsigned int i = 0; i < size; i++) {
+            fingerprints[positions[i]] = members[first + i];
+        }
+    }
+
+    return true;
+}
+
+// Get the index of a name
+long long perfecthash::Lookup(string_view name) const {
+    if (fingerprints.empty()) {
+        return -1;
+    }
+    unsigned long long hash = Hash(name, seed);
+    unsigned int pilot = pilots[Bucket(hash)];
+    unsigned int position = (pilot & DIRECT) ? (pilot & ~DIRECT) :
+                            Position(hash, pilot);
+    return fingerprints[position] == hash ? (long long) position : -1;
+}
+
+// Get the number of names in the set
+size_t perfecthash::QuerySize() const {
+    return fingerprints.size();
+}
@@ -0,0 +1,69 @@
+// AUTHOR:      Hongru He
+// FILENAME:    perfecthash.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_PERFECTHASH_H
+#define P4_PERFECTHASH_H
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// The PerfectHash class maps a fixed set of names to the indices 0 to n - 1
+// without collisions, and rejects names outside the set by a fingerprint.
+// Class Invariants:
+// 1.   Every name of the set has a distinct index below the size of the set.
+// 2.   fingerprints[i] is the 64-bit hash of the name with index i.
+// 3.   The structure never changes after it is built.
+
+class perfecthash {
+private:
+    vector<unsigned int> pilots;
+    vector<unsigned long long> fingerprints;
+    unsigned long long seed;
+    unsigned int bucketCount;
+
+    unsigned int Bucket(unsigned long long) const;
+    // Get the bucket of a hash
+
+    unsigned int Position(unsigned long long, unsigned int) const;
+    // Get the index of a hash displaced by a pilot
+
+    bool TryBuild(const vector<unsigned long long>&);
+    // Search the pilots for the current seed
+
+public:
+    perfecthash();
+    // Default Constructor
+    // Explanation:     Initializes a perfect hash of the empty set.
+    // Precondition:    None.
+    // Postcondition:   Every lookup is rejected.
+
+    explicit perfecthash(const vector<string_view>&,
+                         vector<unsigned int>* = nullptr);
+    // Overloaded Constructor
+    // Explanation:     Builds a minimal perfect hash over the names. If a
+    //                  vector is given, it receives the index of every name
+    //                  in order, so the caller need not hash them again.
+    // Precondition:    The names are distinct.
+    // Postcondition:   PerfectHash object maps each name to its own index.
+
+    static unsigned long long Hash(string_view, unsigned long long);
+    // Hash a name with a seed
+
+    long long Lookup(string_view) const;
+    // Get the index of a name
+    // Explanation:     Takes one hash, the pilot of its bucket and the stored
+    //                  fingerprint of the resulting index.
+    // Precondition:    None.
+    // Postcondition:   Return the index of the name, or -1 if the name is
+    //                  not in the set.
+
+    size_t QuerySize() const;
+    // Get the number of names in the set
+};
+
+
+#endif //P4_PERFECTHASH_H
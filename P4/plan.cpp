@@ -19,6 +19,13 @@ using namespace std;
 //      parameter's resource after 'this' Plan taking over the ownership
 // 3.   The resize method maintains the integrity of the planList, ensuring
 //      no formulas are lost during the resizing process.
+// 4.   planHash is the sum of StepHash over the first 'size' formulas. Every
+//      function that changes a step updates it: Add adds a term, Remove
+//      subtracts one, Replace swaps one, and anything that rewrites the list
+//      wholesale calls Reindex.
+// 5.   When materialIndex is set, it holds exactly the first 'size' formulas
+//      keyed by their index and is updated alongside planHash. Copies get
+//      their own index; moves take it over.
 
 // Default Constructor
 // Initializes a Plan object with the default setting
@@ -26,6 +33,7 @@ plan::plan() {
     size = 0;
     capacity = 10;
     planList = new formula[capacity];
+    planHash = 0;
 }
 
 // Overloaded Constructor
@@ -37,6 +45,7 @@ plan::plan(formula* formulaList, int inputNum) {
     for (int i= 0; i < size; i++) {
         planList[i] = formulaList[i];
     }
+    Reindex();
 }
 
 // Deconstructor
@@ -56,6 +65,10 @@ plan::plan(const plan& other) {
     for (int i = 0; i < size; i++) {
         planList[i] = other.planList[i];
     }
+    planHash = other.planHash;
+    if (other.materialIndex) {
+        materialIndex.reset(new materialindex(*other.materialIndex));
+    }
 }
 
 // Copy Assignment Operator
@@ -70,14 +83,19 @@ plan& plan::operator=(const plan& other) {
         for (int i = 0; i < size; i++) {
             planList[i] = other.planList[i];
         }
+        planHash = other.planHash;
+        materialIndex.reset();
+        if (other.materialIndex) {
+            materialIndex.reset(new materialindex(*other.materialIndex));
+        }
     }
 
     return *this;
 }
 
 // Comparison Operator
-bool plan::operator==(const plan& other) {
-    if (size != other.size)
+bool plan::operator==(const plan& other) const {
+    if (size != other.size || planHash != other.planHash)
         return false;
 
     for (int i = 0; i < size; i++) {
@@ -88,7 +106,7 @@ bool plan::operator==(const plan& other) {
 }
 
 // Overloaded Comparison Operator
-bool plan::operator!=(const plan& other) {
+bool plan::operator!=(const plan& other) const {
     return !operator==(other);
 }
 
@@ -98,10 +116,13 @@ plan::plan(plan&& other) noexcept {
     planList = other.planList;
     size = other.size;
     capacity = other.capacity;
+    planHash = other.planHash;
+    materialIndex = std::move(other.materialIndex);
 
     other.planList = nullptr;
     other.size = 0;
     other.capacity = 0;
+    other.planHash = 0;
 }
 
 // Move Assignment Operator
@@ -112,10 +133,13 @@ plan& plan::operator=(plan&& other) noexcept {
         planList = other.planList;
         size = other.size;
         capacity = other.capacity;
+        planHash = other.planHash;
+        materialIndex = std::move(other.materialIndex);
 
         other.planList = nullptr;
         other.size = 0;
         other.capacity = 0;
+        other.planHash = 0;
     }
     return *this;
 }
@@ -138,25 +162,21 @@ plan& plan::operator+(plan& other) {
     for (int i = 0; i < other.size; i++) {
         this->Add(std::move(other.planList[i]));
     }
+    // The moved-from Formulas are empty now.
+    other.Reindex();
     return *this;
 }
 
 // Resize
 // Expand the capacity of the Plan object when necessary.
 void plan::Resize() {
-    int newCapacity = capacity * 2;
+    int newCapacity = capacity > 0 ? capacity * 2 : 10;
     formula* newList = new formula[newCapacity];
     for (int i = 0; i < size; i++) {
-        newList[i] = planList[i];
+        newList[i] = std::move(planList[i]);
     }
     delete[] planList;
-
-    // Deep copy from the newList
-    planList = new formula[newCapacity];
-    for (int j = 0; j < size; j++) {
-        planList[j] = newList[j];
-    }
-    delete[] newList;
+    planList = newList;
     capacity = newCapacity;
 }
 
@@ -167,7 +187,12 @@ void plan::Add(formula&& newFor) {
         Resize();
     }
 
-    planList[size++] = std::move(newFor);
+    planList[size] = std::move(newFor);
+    planHash += StepHash(planList[size], size);
+    if (materialIndex) {
+        materialIndex->Insert(size, planList[size]);
+    }
+    size++;
 }
 
 // Remove
@@ -175,6 +200,10 @@ void plan::Add(formula&& newFor) {
 void plan::Remove() {
     if (size > 0) {
         size--;
+        planHash -= StepHash(planList[size], size);
+        if (materialIndex) {
+            materialIndex->Erase(size, planList[size]);
+        }
     }
 }
 
@@ -184,7 +213,15 @@ void plan::Replace(formula&& newFor, int index) {
     if (index < 0 || index >= size) {
         throw std::out_of_range("Index out of range.");
     }
+    planHash -= StepHash(planList[index], index);
+    if (materialIndex) {
+        materialIndex->Erase(index, planList[index]);
+    }
     planList[index] = std::move(newFor);
+    planHash += StepHash(planList[index], index);
+    if (materialIndex) {
+        materialIndex->Insert(index, planList[index]);
+    }
 }
 
 // Display Formula
@@ -198,4 +235,79 @@ string plan::DisplayFormula() {
     }
 
     return ssr.str();
-}
\ No newline at end of file
+}
+
+// Query Formula
+// Returns the Formula of a step
+const formula& plan::QueryFormula(int index) const {
+    if (index < 0 || index >= size) {
+        throw std::out_of_range("Index out of range.");
+    }
+    return planList[index];
+}
+
+// Query Size
+int plan::QuerySize() const {
+    return size;
+}
+
+// Enable Material Index
+// Indexes every step; later edits keep the index up to date
+void plan::EnableMaterialIndex() {
+    if (!materialIndex) {
+        materialIndex.reset(new materialindex());
+        for (int i = 0; i < size; i++) {
+            materialIndex->Insert(i, planList[i]);
+        }
+    }
+}
+
+// Query Producers
+// Returns the indices of the steps that produce the material
+const vector<int>& plan::QueryProducers(const string& material) const {
+    if (!materialIndex) {
+        throw logic_error("The material index is not enabled.");
+    }
+    return materialIndex->QueryProducers(material);
+}
+
+// Query Consumers
+// Returns the indices of the steps that consume the material
+const vector<int>& plan::QueryConsumers(const string& material) const {
+    if (!materialIndex) {
+        throw logic_error("The material index is not enabled.");
+    }
+    return materialIndex->QueryConsumers(material);
+}
+
+// Get Hash
+// Returns the rolling hash of the Plan
+unsigned long long plan::QueryHash() const {
+    return planHash;
+}
+
+// Step Hash
+// Mixes the recipe hash with the index through the SplitMix64 finalizer, so
+// terms of neighbouring steps do not cancel out when summed
+unsigned long long plan::StepHash(const formula& step, int index) {
+    unsigned long long term = step.QueryRecipeHash() +
+            0x9E3779B97F4A7C15ULL * (unsigned long long) (index + 1);
+    term = (term ^ (term >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    term = (term ^ (term >> 27)) * 0x94D049BB133111EBULL;
+    return term ^ (term >> 31);
+}
+
+// Reindex
+// Recomputes the rolling hash and the material index from every step
+void plan::Reindex() {
+    planHash = 0;
+    for (int i = 0; i < size; i++) {
+        planHash += StepHash(planList[i], i);
+    }
+    if (materialIndex) {
+        materialIndex->Clear();
+        for (int i = 0; i < size; i++) {
+            materialIndex->Insert(i, planList[i]);
+        }
+    }
+}
@@ -6,6 +6,7 @@
 #ifndef P4_PLAN_H
 #define P4_PLAN_H
 #include "formula.h"
+#include "materialindex.h"
 #include <iostream>
 #include <memory>
 
@@ -15,6 +16,18 @@ class plan {
 protected:
     formula* planList;
     int size, capacity;
+    unsigned long long planHash;
+    unique_ptr<materialindex> materialIndex;
+
+    // Get the contribution of one step to the Plan's rolling hash.
+    // Explanation:     Mixes the Formula's recipe hash with its index, so
+    //                  the same Formulas in a different order hash apart.
+    // Precondition:    the parameter int is the index of the Formula.
+    // Postcondition:   Return the step's term of the rolling hash.
+    static unsigned long long StepHash(const formula&, int);
+
+    // Recompute the rolling hash and the material index from every step.
+    void Reindex();
 
     // Resize the Plan when necessary.
     // Explanation:     Resizes the Plan's capacity if the current size
@@ -57,10 +70,12 @@ public:
     // Precondition:    the parameter is a valid, existing Plan object.
     // Postcondition:   The original Plan is a copy of the given one.
 
-    bool operator==(const plan&);
+    bool operator==(const plan&) const;
     // Overloaded Relational Operator
+    // Explanation:     Plans with different rolling hashes are rejected in
+    //                  O(1) before any Formula is compared.
 
-    bool operator!=(const plan&);
+    bool operator!=(const plan&) const;
     // Overloaded Relational Operator
 
     plan(plan&&) noexcept;
@@ -111,7 +126,54 @@ public:
     //                  in the Plan.
     // Precondition:    None.
     // Postcondition:   Returns a string without modifying the Plan.
+
+    const formula& QueryFormula(int) const;
+    // Get the Formula of a step
+    // Precondition:    the parameter int is within the range of the Plan's
+    //                  size; otherwise an out_of_range exception is thrown.
+    // Postcondition:   Return the Formula without copying it.
+
+    int QuerySize() const;
+    // Get the number of Formulas in the Plan
+
+    void EnableMaterialIndex();
+    // Maintain an index from materials to steps.
+    // Explanation:     Indexes every step once; from then on Add, Remove and
+    //                  Replace keep the index up to date.
+    // Precondition:    None.
+    // Postcondition:   QueryProducers and QueryConsumers can be used.
+
+    const vector<int>& QueryProducers(const string&) const;
+    // Get the indices of the steps that produce a material.
+    // Explanation:     The indices are in no particular order.
+    // Precondition:    The material index is enabled; otherwise a
+    //                  logic_error exception is thrown.
+    // Postcondition:   Return an empty list for an unknown material.
+
+    const vector<int>& QueryConsumers(const string&) const;
+    // Get the indices of the steps that consume a material.
+    // Explanation:     The indices are in no particular order.
+    // Precondition:    The material index is enabled; otherwise a
+    //                  logic_error exception is thrown.
+    // Postcondition:   Return an empty list for an unknown material.
+
+    unsigned long long QueryHash() const;
+    // Get the rolling hash of the Plan.
+    // Explanation:     The hash is the sum of every step's term, kept up to
+    //                  date by Add, Remove and Replace in O(1).
+    // Precondition:    None.
+    // Postcondition:   Return the hash without modifying the Plan.
 };
 
+namespace std {
+    // Hash a Plan by its steps, so equal Plans share a hash.
+    template <>
+    struct hash<plan> {
+        size_t operator()(const plan& target) const noexcept {
+            return (size_t) target.QueryHash();
+        }
+    };
+}
+
 
 #endif //P4_PLAN_H
@@ -0,0 +1,159 @@
+// AUTHOR:      Hongru He
+// FILENAME:    plandag.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "plandag.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   For every material the builder keeps the open group, whether it
+//      writes, and the node that stands for the group closed before it:
+//      -1 if there was none, its step if it had one, or else its join. A
+//      step links from that node and joins the open group; a step of the
+//      other kind first closes the open group into a new join.
+// 2.   A step that reads and then writes a material is the last reader of
+//      the group it closes and cannot wait for its own join, so it is left
+//      out of the join and the writers of its group link from it directly.
+// 3.   A join is created while the step that first depends on it is built,
+//      after every member of its group, and goes into the order right
+//      before that step; its predecessors are complete once it exists.
+// 4.   linked[p] holds the last node that got an edge from p, which drops
+//      duplicate edges without a search.
+
+// Overloaded Constructor
+plandag::plandag(const plan& source) {
+    stepCount = source.QuerySize();
+    successors.resize(stepCount);
+    predecessors.resize(stepCount);
+    order.reserve(stepCount);
+
+    struct material {
+        vector<int> group;
+        bool writing = false;
+        int closed = -1;
+        int direct = -1;
+    };
+    unordered_map<string, int> materialIds;
+    vector<material> materials;
+    vector<int> linked(stepCount, -1);
+
+    auto intern = [&](const string& name) {
+        auto item = materialIds.emplace(name, (int) materials.size());
+        if (item.second) {
+            materials.emplace_back();
+        }
+        return item.first->second;
+    };
+    auto link = [&](int from, int to) {
+        if (from >= 0 && from != to && linked[from] != to) {
+            linked[from] = to;
+            successors[from].push_back(to);
+            predecessors[to].push_back(from);
+            edgeCount++;
+        }
+    };
+    // Closes a group into the node that stands for it
+    auto join = [&](const vector<int>& group, int skip) {
+        int size = (int) group.size() - (skip >= 0 ? 1 : 0);
+        if (size <= 1) {
+            return size == 0 ? -1 : group[0];
+        }
+        int node = (int) successors.size();
+        successors.emplace_back();
+        predecessors.emplace_back();
+        linked.push_back(-1);
+        order.push_back(node);
+        for (int member : group) {
+            if (member != skip) {
+                link(member, node);
+            }
+        }
+        return node;
+    };
+
+    for (int step = 0; step < stepCount; step++) {
+        const formula& current = source.QueryFormula(step);
+        for (int i = 0; i < current.QueryInputSize(); i++) {
+            material& read = materials[intern(current.QueryInputMaterial(i))];
+            if (read.writing) {
+                read.closed = join(read.group, -1);
+                read.direct = -1;
+                read.group.clear();
+                read.writing = false;
+            }
+            link(read.closed, step);
+            if (read.group.empty() || read.group.back() != step) {
+                read.group.push_back(step);
+            }
+        }
+        for (int j = 0; j < current.QueryOutputSize(); j++) {
+            material& written =
+                    materials[intern(current.QueryOutputMaterial(j))];
+            if (!written.writing) {
+                bool reader = !written.group.empty() &&
+                              written.group.back() == step;
+                written.closed = join(written.group, reader ? step : -1);
+                written.direct = reader ? step : -1;
+                written.group.clear();
+                written.writing = true;
+            }
+            link(written.closed, step);
+            link(written.direct, step);
+            if (written.group.empty() || written.group.back() != step) {
+                written.group.push_back(step);
+            }
+        }
+        sort(predecessors[step].begin(), predecessors[step].end());
+        order.push_back(step);
+    }
+}
+
+// Query Size
+int plandag::QuerySize() const {
+    return stepCount;
+}
+
+// Query Node Count
+int plandag::QueryNodeCount() const {
+    return (int) successors.size();
+}
+
+// Query Join
+bool plandag::QueryJoin(int node) const {
+    if (node < 0 || node >= QueryNodeCount()) {
+        throw out_of_range("Index out of range.");
+    }
+    return node >= stepCount;
+}
+
+// Query Edge Count
+long long plandag::QueryEdgeCount() const {
+    return edgeCount;
+}
+
+// Query Order
+const vector<int>& plandag::QueryOrder() const {
+    return order;
+}
+
+// Query Successors
+const vector<int>& plandag::QuerySuccessors(int node) const {
+    if (node < 0 || node >= QueryNodeCount()) {
+        throw out_of_range("Index out of range.");
+    }
+    return successors[node];
+}
+
+// Query Predecessors
+const vector<int>& plandag::QueryPredecessors(int node) const {
+    if (node < 0 || node >= QueryNodeCount()) {
+        throw out_of_range("Index out of range.");
+    }
+    return predecessors[node];
+}
@@ -0,0 +1,73 @@
+// AUTHOR:      Hongru He
+// FILENAME:    plandag.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_PLANDAG_H
+#define P4_PLANDAG_H
+#include "plan.h"
+#include <vector>
+
+using namespace std;
+
+// The PlanDAG class derives the dependencies between the steps of a Plan
+// from the materials they read and write. A step reads its inputs, since
+// it checks them, and writes its outputs. Writes only add to a quantity, so
+// two writes of the same material commute and are not ordered.
+// Class Invariants:
+// 1.   Per material, consecutive writes in plan order form a group, and so
+//      do consecutive reads. A reader depends on every step of the last
+//      write group before it and a writer on every step of the last read
+//      group before it, so a reader reaches every earlier writer through a
+//      path, and the writers of one group are not ordered.
+// 2.   A group of more than one step is joined by a node that takes no
+//      time: the group points to the join and the join to the steps that
+//      depend on the group. Steps are nodes 0 to QuerySize() - 1 and joins
+//      follow them, so the number of edges is linear in the Plan.
+// 3.   QueryOrder lists every node after all of its predecessors, a pair
+//      of nodes has at most one edge, and between steps every edge goes
+//      from a lower to a higher step index.
+// 4.   Steps that are not connected by a path share no material that one
+//      reads and the other writes, so they can run in any order.
+
+class plandag {
+private:
+    vector<vector<int>> successors;
+    vector<vector<int>> predecessors;
+    vector<int> order;
+    int stepCount = 0;
+    long long edgeCount = 0;
+
+public:
+    explicit plandag(const plan&);
+    // Overloaded Constructor
+    // Explanation:     Builds the dependencies of every step in one pass
+    //                  over the Plan.
+    // Precondition:    None.
+    // Postcondition:   PlanDAG object holds one node per step and one per
+    //                  join.
+
+    int QuerySize() const;
+    // Get the number of steps
+
+    int QueryNodeCount() const;
+    // Get the number of steps and joins
+
+    bool QueryJoin(int) const;
+    // Check if a node is a join rather than a step
+
+    long long QueryEdgeCount() const;
+    // Get the number of edges, including those of the joins
+
+    const vector<int>& QueryOrder() const;
+    // Get every node in an order that respects the dependencies
+
+    const vector<int>& QuerySuccessors(int) const;
+    // Get the nodes that depend on a node, in the order of QueryOrder
+
+    const vector<int>& QueryPredecessors(int) const;
+    // Get the nodes a node depends on, in increasing order
+};
+
+
+#endif //P4_PLANDAG_H
@@ -0,0 +1,34 @@
+// AUTHOR:      Hongru He
+// FILENAME:    planfusion.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "planfusion.h"
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Fusion follows the order of the Plan; only neighbouring steps are
+//      fused, so no step runs earlier or later than it would have.
+// 2.   A chain is cut when a later step consumes one of its chained
+//      materials, since fusing would hide that material from the later
+//      step.
+
+// Query Fusible
+bool planfusion::QueryFusible(const formula& first, const formula& second) {
+    if (first.QueryOutputSize() == 0) {
+        return false;
+    }
+    for (int j = 0; j < first.QueryOutputSize(); j++) {
+        int consumed = 0;
+        for (int i = 0; i < second.QueryInputSize(); i++) {
+            if (second.QueryInputMaterial(i) == first.QueryOutputMaterial(j)) {
+                consumed += second.QueryInputNumber(i);
+            }
+        }
+        if (consumed != first.QueryOutputNumber(j)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,121 @@
+// AUTHOR:      Hongru He
+// FILENAME:    planfusion.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_PLANFUSION_H
+#define P4_PLANFUSION_H
+#include "formula.h"
+#include "plan.h"
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// The PlanFusion class fuses chains of Plan steps into single Formulas.
+// A step is chained to the one before it when it consumes every output of
+// that step, in exactly the numbers produced, and no later step needs those
+// outputs. The chain then runs as one fused Formula, which draws its outcome
+// once from the combined distribution of its steps.
+// Class Invariants:
+// 1.   A fused Formula has the inputs of its chain minus the chained
+//      materials and the outputs of its last step.
+// 2.   Expand restores the original steps, with the proficiency they gained
+//      while fused, so a run can be audited step by step.
+// 3.   Fuse and Expand never modify the Plan they are given.
+// 4.   A fused Plan does not end with the same Stockpile as the original.
+//      Applying a step checks its inputs without consuming them, so the
+//      original leaves every chained material in the Stockpile, while the
+//      fused Formula never adds it. The chained step's input check is
+//      likewise replaced by the outcome of the step before it. Expand the
+//      Plan when the intermediates must be kept.
+
+class planfusion {
+public:
+    static bool QueryFusible(const formula&, const formula&);
+    // Check if two steps can be fused
+    // Explanation:     The second step must consume every output of the
+    //                  first, in exactly the numbers the first produces.
+    // Precondition:    None.
+    // Postcondition:   Return the boolean result.
+
+    template <typename PlanType>
+    static PlanType Fuse(const PlanType&, int = 4);
+    // Fuse the chained steps of a Plan
+    // Explanation:     Walks the Plan in order and fuses every run of up to
+    //                  the given number of chained steps into one Formula.
+    //                  The chained materials are not written to the
+    //                  Stockpile when the fused Plan runs.
+    // Precondition:    The chain length is at least 1.
+    // Postcondition:   Return the fused Plan; the original is not modified.
+
+    template <typename PlanType>
+    static PlanType Expand(const PlanType&);
+    // Expand the fused steps of a Plan
+    // Explanation:     Replaces every fused Formula by copies of its steps.
+    // Precondition:    None.
+    // Postcondition:   Return the expanded Plan; the original is not
+    //                  modified.
+};
+
+// Fuse
+template <typename PlanType>
+PlanType planfusion::Fuse(const PlanType& source, int maxChain) {
+    int n = source.QuerySize();
+
+    // The last step that consumes each material
+    unordered_map<string, int> lastConsumer;
+    for (int i = 0; i < n; i++) {
+        const formula& step = source.QueryFormula(i);
+        for (int k = 0; k < step.QueryInputSize(); k++) {
+            lastConsumer[step.QueryInputMaterial(k)] = i;
+        }
+    }
+
+    PlanType result;
+    int i = 0;
+    while (i < n) {
+        formula current(source.QueryFormula(i));
+        int length = 1;
+        int next = i + 1;
+        while (length < maxChain && next < n &&
+               QueryFusible(current, source.QueryFormula(next))) {
+            bool unshared = true;
+            for (int k = 0; k < current.QueryOutputSize(); k++) {
+                unshared = unshared &&
+                           lastConsumer[current.QueryOutputMaterial(k)] ==
+                           next;
+            }
+            if (!unshared) {
+                break;
+            }
+            current = formula::Fuse(current, source.QueryFormula(next));
+            length++;
+            next++;
+        }
+        result.Add(std::move(current));
+        i = next;
+    }
+    return result;
+}
+
+// Expand
+template <typename PlanType>
+PlanType planfusion::Expand(const PlanType& source) {
+    PlanType result;
+    for (int i = 0; i < source.QuerySize(); i++) {
+        const formula& step = source.QueryFormula(i);
+        if (step.QueryFused()) {
+            for (const formula& part : step.QueryFusedSteps()) {
+                result.Add(formula(part));
+            }
+        }
+        else {
+            result.Add(formula(step));
+        }
+    }
+    return result;
+}
+
+
+#endif //P4_PLANFUSION_H
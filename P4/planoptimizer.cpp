@@ -0,0 +1,515 @@
+// AUTHOR:      Hongru He
+// FILENAME:    planoptimizer.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "planoptimizer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Materials and recipes are interned to indices; a recipe is keyed by
+//      its recipe hash and takes its odds from its first step in the Plan.
+// 2.   A step runs with the fraction of its inputs that are available,
+//      consumes that fraction of each and produces that fraction times the
+//      expected yield. Its recipe gains the fraction times the chance of
+//      success in expected experience; the recipe is one level up once the
+//      expected experience reaches what the Formula still needs.
+// 3.   The bound of a prefix is its value plus outputWeight times the most
+//      every remaining step could add to the final outputs, at full inputs
+//      and at the higher level. Input costs are never negative, so it never
+//      underestimates.
+// 4.   Branch and bound keeps dependencies as bit masks, so it is limited to
+//      63 steps; parallel workers take subtrees of the first two levels and
+//      share the incumbent value through an atomic.
+
+namespace {
+    const double EPSILON = 1e-9;
+    const int MASKSTEPS = 63;
+}
+
+// The state shared by the workers of one branch and bound search.
+struct planoptimizer::searchcontext {
+    vector<unsigned long long> predecessorMask;
+    atomic<double> bestValue{0};
+    mutex bestLock;
+    vector<int> bestOrder;
+    atomic<long long> nodes{0};
+    atomic<bool> stopped{false};
+    chrono::steady_clock::time_point deadline;
+};
+
+// Overloaded Constructor
+planoptimizer::planoptimizer(const plan& target, reorderoptions settings) {
+    options = settings;
+    Build(target, nullptr);
+}
+
+// Overloaded Constructor
+planoptimizer::planoptimizer(const plan& target, const stockpile& resources,
+                             reorderoptions settings) {
+    options = settings;
+    Build(target, &resources);
+}
+
+// Build
+// Interns materials and recipes, and links every step to the earlier steps
+// it depends on in time linear in the size of the Plan
+void planoptimizer::Build(const plan& target, const stockpile* resources) {
+    unordered_map<string, int> materialIds;
+    unordered_map<unsigned long long, int> recipeIds;
+    auto intern = [&materialIds](const string& material) {
+        auto item = materialIds.emplace(material, (int) materialIds.size());
+        return item.first->second;
+    };
+
+    int n = target.QuerySize();
+    steps.resize(n);
+    for (int s = 0; s < n; s++) {
+        const formula& current = target.QueryFormula(s);
+        for (int i = 0; i < current.QueryInputSize(); i++) {
+            steps[s].inputs.push_back({intern(current.QueryInputMaterial(i)),
+                                       current.QueryInputNumber(i)});
+        }
+        for (int j = 0; j < current.QueryOutputSize(); j++) {
+            steps[s].outputs.push_back(
+                    {intern(current.QueryOutputMaterial(j)),
+                     current.QueryOutputNumber(j)});
+        }
+
+        auto recipe = recipeIds.emplace(current.QueryRecipeHash(),
+                                        (int) recipes.size());
+        if (recipe.second) {
+            recipeodds odds;
+            for (int level = 0; level < 2; level++) {
+                odds.success[level] = 1 - current.QueryTierProbability(0,
+                                                                       level);
+                odds.yield[level] = current.QueryExpectedYield(level);
+            }
+            odds.experienceToLevel = current.QueryExperienceToLevel();
+            recipes.push_back(odds);
+        }
+        steps[s].recipe = recipe.first->second;
+    }
+
+    int materialCount = (int) materialIds.size();
+    vector<bool> produced(materialCount, false);
+    vector<bool> consumed(materialCount, false);
+    for (const step& current : steps) {
+        for (const pair<int, int>& input : current.inputs) {
+            consumed[input.first] = true;
+        }
+        for (const pair<int, int>& output : current.outputs) {
+            produced[output.first] = true;
+        }
+    }
+    rawMaterial.assign(materialCount, false);
+    finalMaterial.assign(materialCount, false);
+    for (int m = 0; m < materialCount; m++) {
+        rawMaterial[m] = consumed[m] && !produced[m];
+        finalMaterial[m] = produced[m] && !consumed[m];
+    }
+
+    limitedStock = resources != nullptr;
+    initialStock.assign(materialCount, 0);
+    if (resources) {
+        for (const auto& material : materialIds) {
+            initialStock[material.second] =
+                    max(resources->QueryQuantity(material.first), 0);
+        }
+    }
+
+    for (step& current : steps) {
+        const recipeodds& odds = recipes[current.recipe];
+        int bestLevel = odds.experienceToLevel >= 0 ? 1 : 0;
+        current.optimistic = 0;
+        for (const pair<int, int>& output : current.outputs) {
+            if (finalMaterial[output.first]) {
+                current.optimistic += output.second * odds.yield[bestLevel];
+            }
+        }
+    }
+
+    // One pass in plan order: a step follows the previous step of its
+    // recipe and the last earlier producer of each of its inputs
+    successors.assign(n, vector<int>());
+    predecessors.assign(n, vector<int>());
+    vector<int> lastOfRecipe(recipes.size(), -1);
+    vector<int> lastProducer(materialCount, -1);
+    vector<int> linked(n, -1);
+    auto link = [this, &linked](int earlier, int later) {
+        if (earlier >= 0 && linked[earlier] != later) {
+            linked[earlier] = later;
+            successors[earlier].push_back(later);
+            predecessors[later].push_back(earlier);
+        }
+    };
+    for (int later = 0; later < n; later++) {
+        link(lastOfRecipe[steps[later].recipe], later);
+        for (const pair<int, int>& input : steps[later].inputs) {
+            link(lastProducer[input.first], later);
+        }
+        lastOfRecipe[steps[later].recipe] = later;
+        for (const pair<int, int>& output : steps[later].outputs) {
+            lastProducer[output.first] = later;
+        }
+    }
+}
+
+// Start
+planoptimizer::state planoptimizer::Start() const {
+    state result;
+    result.stock = initialStock;
+    result.successes.assign(recipes.size(), 0);
+    return result;
+}
+
+// Run
+// Runs the available fraction of one step on the expected state
+void planoptimizer::Run(int index, state& current) const {
+    const step& target = steps[index];
+    double fraction = 1;
+    for (const pair<int, int>& input : target.inputs) {
+        if (!rawMaterial[input.first] || limitedStock) {
+            fraction = min(fraction, current.stock[input.first] /
+                                     input.second);
+        }
+    }
+    fraction = max(fraction, 0.0);
+    if (fraction <= EPSILON) {
+        return;
+    }
+
+    for (const pair<int, int>& input : target.inputs) {
+        current.stock[input.first] -= fraction * input.second;
+        if (rawMaterial[input.first]) {
+            current.input += fraction * input.second;
+        }
+    }
+
+    const recipeodds& odds = recipes[target.recipe];
+    int level = odds.experienceToLevel >= 0 &&
+                current.successes[target.recipe] + EPSILON >=
+                odds.experienceToLevel ? 1 : 0;
+    for (const pair<int, int>& output : target.outputs) {
+        double made = fraction * output.second * odds.yield[level];
+        current.stock[output.first] += made;
+        if (finalMaterial[output.first]) {
+            current.output += made;
+        }
+    }
+    current.successes[target.recipe] += fraction * odds.success[level];
+}
+
+// Value
+double planoptimizer::Value(const state& current) const {
+    return options.outputWeight * current.output -
+           options.inputWeight * current.input;
+}
+
+// Finish
+reorderresult planoptimizer::Finish(const vector<int>& order) const {
+    state current = Start();
+    for (int index : order) {
+        Run(index, current);
+    }
+    reorderresult result;
+    result.order = order;
+    result.value = Value(current);
+    result.expectedOutput = current.output;
+    result.expectedInput = current.input;
+    return result;
+}
+
+// Evaluate
+// Checks that the order is a valid permutation before evaluating it
+reorderresult planoptimizer::Evaluate(const vector<int>& order) const {
+    int n = (int) steps.size();
+    if ((int) order.size() != n) {
+        throw invalid_argument("The order must list every step once.");
+    }
+    vector<int> at(n, -1);
+    for (int i = 0; i < n; i++) {
+        if (order[i] < 0 || order[i] >= n || at[order[i]] >= 0) {
+            throw invalid_argument("The order must list every step once.");
+        }
+        at[order[i]] = i;
+    }
+    for (int s = 0; s < n; s++) {
+        for (int before : predecessors[s]) {
+            if (at[before] > at[s]) {
+                throw invalid_argument("The order breaks a dependency.");
+            }
+        }
+    }
+    return Finish(order);
+}
+
+// Greedy
+// Repeatedly runs the available step that adds the most value, preferring
+// the earliest step on ties
+vector<int> planoptimizer::Greedy() const {
+    int n = (int) steps.size();
+    vector<int> waiting(n);
+    for (int s = 0; s < n; s++) {
+        waiting[s] = (int) predecessors[s].size();
+    }
+
+    vector<int> order;
+    state current = Start();
+    vector<bool> done(n, false);
+    while ((int) order.size() < n) {
+        int best = -1;
+        double bestValue = 0;
+        state bestState;
+        for (int s = 0; s < n; s++) {
+            if (done[s] || waiting[s] > 0) {
+                continue;
+            }
+            state next = current;
+            Run(s, next);
+            if (best < 0 || Value(next) > bestValue + EPSILON) {
+                best = s;
+                bestValue = Value(next);
+                bestState = std::move(next);
+            }
+        }
+        done[best] = true;
+        order.push_back(best);
+        current = std::move(bestState);
+        for (int after : successors[best]) {
+            waiting[after]--;
+        }
+    }
+    return order;
+}
+
+// Search
+// Extends the prefix with every available step, best first, and prunes
+// subtrees whose bound cannot beat the incumbent
+void planoptimizer::Search(searchcontext& context, state& current,
+                           unsigned long long placed, vector<int>& prefix,
+                           double remaining) const {
+    if (context.stopped.load(memory_order_relaxed)) {
+        return;
+    }
+    long long visited = context.nodes.fetch_add(1, memory_order_relaxed);
+    if ((visited & 1023) == 0 &&
+        chrono::steady_clock::now() > context.deadline) {
+        context.stopped.store(true);
+        return;
+    }
+
+    int n = (int) steps.size();
+    if ((int) prefix.size() == n) {
+        double value = Value(current);
+        lock_guard<mutex> guard(context.bestLock);
+        if (value > context.bestValue.load() + EPSILON) {
+            context.bestValue.store(value);
+            context.bestOrder = prefix;
+        }
+        return;
+    }
+    if (Value(current) + options.outputWeight * remaining <=
+        context.bestValue.load(memory_order_relaxed) + EPSILON) {
+        return;
+    }
+
+    vector<pair<double, int>> children;
+    vector<state> childStates;
+    vector<int> childSteps;
+    for (int s = 0; s < n; s++) {
+        if ((placed >> s & 1ULL) ||
+            (context.predecessorMask[s] & ~placed) != 0) {
+            continue;
+        }
+        childStates.push_back(current);
+        childSteps.push_back(s);
+        Run(s, childStates.back());
+        children.push_back({-Value(childStates.back()),
+                            (int) childSteps.size() - 1});
+    }
+    sort(children.begin(), children.end());
+
+    for (const pair<double, int>& child : children) {
+        int s = childSteps[child.second];
+        prefix.push_back(s);
+        Search(context, childStates[child.second], placed | 1ULL << s,
+               prefix, remaining - steps[s].optimistic);
+        prefix.pop_back();
+    }
+}
+
+// Exhaustive
+// Seeds the incumbent with the greedy and original orders, then hands the
+// subtrees of the first two levels to the workers
+reorderresult planoptimizer::Exhaustive() const {
+    int n = (int) steps.size();
+    searchcontext context;
+    context.deadline = chrono::steady_clock::now() +
+                       chrono::milliseconds(options.timeLimitMillis);
+    context.predecessorMask.assign(n, 0);
+    for (int s = 0; s < n; s++) {
+        for (int before : predecessors[s]) {
+            context.predecessorMask[s] |= 1ULL << before;
+        }
+    }
+
+    vector<int> original(n);
+    for (int s = 0; s < n; s++) {
+        original[s] = s;
+    }
+    reorderresult greedy = Finish(Greedy());
+    reorderresult identity = Finish(original);
+    reorderresult incumbent = greedy.value >= identity.value ? greedy :
+                                                               identity;
+    context.bestValue.store(incumbent.value);
+    context.bestOrder = incumbent.order;
+
+    double remaining = 0;
+    for (const step& current : steps) {
+        remaining += current.optimistic;
+    }
+
+    vector<vector<int>> roots;
+    for (int a = 0; a < n; a++) {
+        if (context.predecessorMask[a] != 0) {
+            continue;
+        }
+        bool leaf = true;
+        for (int b = 0; b < n; b++) {
+            if (b != a && (context.predecessorMask[b] & ~(1ULL << a)) == 0) {
+                roots.push_back({a, b});
+                leaf = false;
+            }
+        }
+        if (leaf) {
+            roots.push_back({a});
+        }
+    }
+
+    atomic<size_t> nextRoot{0};
+    auto work = [&]() {
+        size_t r;
+        while ((r = nextRoot.fetch_add(1)) < roots.size()) {
+            state current = Start();
+            unsigned long long placed = 0;
+            double left = remaining;
+            for (int s : roots[r]) {
+                Run(s, current);
+                placed |= 1ULL << s;
+                left -= steps[s].optimistic;
+            }
+            vector<int> prefix = roots[r];
+            Search(context, current, placed, prefix, left);
+        }
+    };
+
+    int threadCount = options.threads > 0 ? options.threads :
+                      max(1, (int) thread::hardware_concurrency());
+    threadCount = max(1, min(threadCount, (int) roots.size()));
+    vector<thread> workers;
+    for (int t = 1; t < threadCount; t++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    reorderresult result = Finish(context.bestOrder);
+    result.optimal = !context.stopped.load();
+    result.nodes = context.nodes.load();
+    return result;
+}
+
+// Heuristic
+// Moves one step at a time to another place its dependencies allow and
+// keeps the move if the value does not drop
+reorderresult planoptimizer::Heuristic() const {
+    int n = (int) steps.size();
+    auto deadline = chrono::steady_clock::now() +
+                    chrono::milliseconds(options.timeLimitMillis);
+    reorderresult best = Finish(Greedy());
+    vector<int> order = best.order;
+    vector<int> at(n);
+    mt19937 gen(n);
+    long long moves = 0;
+
+    while (n > 1 && chrono::steady_clock::now() < deadline) {
+        for (int s = 0; s < n; s++) {
+            at[order[s]] = s;
+        }
+        int from = (int) (gen() % n);
+        int moved = order[from];
+        int low = 0;
+        int high = n - 1;
+        for (int before : predecessors[moved]) {
+            low = max(low, at[before] + 1);
+        }
+        for (int after : successors[moved]) {
+            high = min(high, at[after] - 1);
+        }
+        if (low >= high) {
+            continue;
+        }
+        int to = low + (int) (gen() % (high - low + 1));
+        if (to == from) {
+            continue;
+        }
+
+        vector<int> candidate = order;
+        candidate.erase(candidate.begin() + from);
+        candidate.insert(candidate.begin() + to, moved);
+        reorderresult tried = Finish(candidate);
+        moves++;
+        if (tried.value >= best.value - EPSILON) {
+            order = std::move(candidate);
+            if (tried.value > best.value + EPSILON) {
+                best = std::move(tried);
+            }
+        }
+    }
+
+    best.nodes = moves;
+    return best;
+}
+
+// Optimize
+reorderresult planoptimizer::Optimize() const {
+    if (steps.empty()) {
+        reorderresult result;
+        result.optimal = true;
+        return result;
+    }
+    if ((int) steps.size() <= min(options.exhaustiveLimit, MASKSTEPS)) {
+        return Exhaustive();
+    }
+    return Heuristic();
+}
+
+// Reorder
+plan planoptimizer::Reorder(const plan& source, const vector<int>& order) {
+    int n = source.QuerySize();
+    vector<bool> used(n, false);
+    if ((int) order.size() != n) {
+        throw invalid_argument("The order must list every step once.");
+    }
+    plan result;
+    for (int index : order) {
+        if (index < 0 || index >= n || used[index]) {
+            throw invalid_argument("The order must list every step once.");
+        }
+        used[index] = true;
+        result.Add(formula(source.QueryFormula(index)));
+    }
+    return result;
+}
@@ -0,0 +1,151 @@
+// AUTHOR:      Hongru He
+// FILENAME:    planoptimizer.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_PLANOPTIMIZER_H
+#define P4_PLANOPTIMIZER_H
+#include "plan.h"
+#include "stockpile.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// What a PlanOptimizer maximizes and how long it may search.
+// The value of an order is outputWeight * expected final output minus
+// inputWeight * expected raw input used; final outputs are materials no
+// step consumes and raw inputs are materials no step produces.
+struct reorderoptions {
+    double outputWeight = 1;
+    double inputWeight = 0;
+    int exhaustiveLimit = 16;
+    int timeLimitMillis = 1000;
+    int threads = 0;
+};
+
+// The order found by a PlanOptimizer, as indices into the original Plan.
+struct reorderresult {
+    vector<int> order;
+    double value = 0;
+    double expectedOutput = 0;
+    double expectedInput = 0;
+    bool optimal = false;
+    long long nodes = 0;
+};
+
+// The PlanOptimizer class searches the orders of a Plan's steps for the one
+// with the best expected value. Proficiency makes the order matter: the
+// optimizer treats it as shared by every step with the same recipe, as a
+// crafter's skill would be, so steps that run with full inputs level their
+// recipe up sooner. Expected material flows decide how fully each step can
+// run.
+// Class Invariants:
+// 1.   A step that consumes a material stays after the last earlier step
+//      that produces it, and steps with the same recipe keep their relative
+//      order.
+// 2.   Plans up to exhaustiveLimit steps are searched by parallel branch
+//      and bound; the result is optimal unless the time limit ran out.
+//      Larger Plans use a greedy order improved by local search until the
+//      time limit.
+// 3.   Every returned order respects the dependencies.
+
+class planoptimizer {
+private:
+    struct step {
+        vector<pair<int, int>> inputs;
+        vector<pair<int, int>> outputs;
+        int recipe;
+        double optimistic;
+    };
+
+    struct recipeodds {
+        double success[2];
+        double yield[2];
+        int experienceToLevel;
+    };
+
+    struct state {
+        vector<double> stock;
+        vector<double> successes;
+        double output = 0;
+        double input = 0;
+    };
+
+    struct searchcontext;
+
+    vector<step> steps;
+    vector<recipeodds> recipes;
+    vector<bool> rawMaterial;
+    vector<bool> finalMaterial;
+    vector<double> initialStock;
+    bool limitedStock;
+    vector<vector<int>> successors;
+    vector<vector<int>> predecessors;
+    reorderoptions options;
+
+    void Build(const plan&, const stockpile*);
+    // Intern the materials and recipes and find the dependencies
+
+    state Start() const;
+    // Get the state before the first step
+
+    void Run(int, state&) const;
+    // Run one step on an expected state
+
+    double Value(const state&) const;
+    // Get the value of a state
+
+    reorderresult Finish(const vector<int>&) const;
+    // Evaluate a complete order into a result
+
+    vector<int> Greedy() const;
+    // Build an order by always running the best available step next
+
+    void Search(searchcontext&, state&, unsigned long long, vector<int>&,
+                double) const;
+    // Branch and bound below a prefix
+
+    reorderresult Exhaustive() const;
+    // Search every order in parallel
+
+    reorderresult Heuristic() const;
+    // Improve the greedy order by moving steps until the time limit
+
+public:
+    explicit planoptimizer(const plan&, reorderoptions = reorderoptions());
+    // Overloaded Constructor
+    // Explanation:     Initializes a PlanOptimizer with raw inputs assumed
+    //                  to be unlimited.
+    // Precondition:    None.
+    // Postcondition:   PlanOptimizer object is ready to optimize the Plan.
+
+    planoptimizer(const plan&, const stockpile&,
+                  reorderoptions = reorderoptions());
+    // Overloaded Constructor
+    // Explanation:     Initializes a PlanOptimizer whose steps draw on the
+    //                  quantities of the Stockpile.
+    // Precondition:    None.
+    // Postcondition:   PlanOptimizer object is ready to optimize the Plan.
+
+    reorderresult Optimize() const;
+    // Find the best order of the steps
+    // Precondition:    None.
+    // Postcondition:   Return the best order found and its value.
+
+    reorderresult Evaluate(const vector<int>&) const;
+    // Get the expected value of an order
+    // Precondition:    The order is a permutation of the steps that respects
+    //                  the dependencies; otherwise an invalid_argument
+    //                  exception is thrown.
+    // Postcondition:   Return the order with its value.
+
+    static plan Reorder(const plan&, const vector<int>&);
+    // Build a Plan with the steps of another in a given order
+    // Precondition:    The order is a permutation of the steps; otherwise
+    //                  an invalid_argument exception is thrown.
+    // Postcondition:   Return the new Plan; the original is not modified.
+};
+
+
+#endif //P4_PLANOPTIMIZER_H
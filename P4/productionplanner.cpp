@@ -0,0 +1,193 @@
+// AUTHOR:      Hongru He
+// FILENAME:    productionplanner.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "productionplanner.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Nodes are interned per Plan call; a node's inputs are the inputs of
+//      its chosen producer.
+// 2.   Order returns a reverse post-order of the producer graph, so every
+//      node comes before its inputs, and the demand pass walks that order
+//      once. Order throws on the first edge back into its path, whether or
+//      not the stock would have covered the cycle.
+// 3.   The plan is built by walking the order backwards, so the crafts of
+//      inputs come first.
+
+namespace {
+    const double EPSILON = 1e-9;
+}
+
+// Overloaded Constructor
+productionplanner::productionplanner(const recipecatalog& recipes,
+                                     yieldmode yieldMode) {
+    catalog = &recipes;
+    mode = yieldMode;
+}
+
+// Intern
+// Creates the node of a material, picking the lowest-id producer
+int productionplanner::Intern(const string& material,
+                              const stockpile& resources) {
+    auto item = nodeIds.find(material);
+    if (item != nodeIds.end()) {
+        return item->second;
+    }
+
+    int id = (int) nodes.size();
+    nodeIds.emplace(material, id);
+    nodes.emplace_back();
+    nodes[id].material = material;
+    nodes[id].stock = max(resources.QueryQuantity(material), 0);
+
+    const vector<int>& producers = catalog->QueryProducers(material);
+    if (!producers.empty()) {
+        nodes[id].producer = *min_element(producers.begin(), producers.end());
+    }
+    return id;
+}
+
+// Throw Cycle
+// Names the materials on the path from the input back to itself
+void productionplanner::ThrowCycle(const vector<pair<int, int>>& path,
+                                   int input) const {
+    size_t first = 0;
+    while (path[first].first != input) {
+        first++;
+    }
+    string message = "Recipe cycle: " + nodes[input].material;
+    for (size_t i = first + 1; i < path.size(); i++) {
+        message += (i == first + 1 ? " needs " : ", which in turn needs ") +
+                   nodes[path[i].first].material;
+    }
+    throw runtime_error(message + ", which in turn needs " +
+                        nodes[input].material + ".");
+}
+
+// Order
+// Iterative DFS over the producer graph; inputs are interned on the way. A
+// node is 1 while it is on the path and 2 once it is finished, so an input
+// still at 1 closes a cycle.
+vector<int> productionplanner::Order(const vector<int>& targets,
+                                     const stockpile& resources) {
+    vector<int> postOrder;
+    vector<char> visited;
+    vector<pair<int, int>> path;
+    for (int target : targets) {
+        visited.resize(nodes.size(), 0);
+        if (visited[target]) {
+            continue;
+        }
+        visited[target] = 1;
+        path.push_back({target, 0});
+        while (!path.empty()) {
+            int current = path.back().first;
+            int next = path.back().second++;
+            if (next == 0 && nodes[current].producer >= 0) {
+                const formula& recipe =
+                        catalog->QueryFormula(nodes[current].producer);
+                int outputNumber = 0;
+                for (int j = 0; j < recipe.QueryOutputSize(); j++) {
+                    if (recipe.QueryOutputMaterial(j) ==
+                        nodes[current].material) {
+                        outputNumber += recipe.QueryOutputNumber(j);
+                    }
+                }
+                nodes[current].yield =
+                        outputNumber * craftabilitysolver::QueryYield(recipe,
+                                                                      mode);
+                for (int i = 0; i < recipe.QueryInputSize(); i++) {
+                    int input = Intern(recipe.QueryInputMaterial(i),
+                                       resources);
+                    nodes[current].inputs.push_back(
+                            {input, recipe.QueryInputNumber(i)});
+                }
+                visited.resize(nodes.size(), 0);
+            }
+
+            if (next < (int) nodes[current].inputs.size()) {
+                int input = nodes[current].inputs[next].first;
+                if (visited[input] == 0) {
+                    visited[input] = 1;
+                    path.push_back({input, 0});
+                }
+                else if (visited[input] == 1) {
+                    ThrowCycle(path, input);
+                }
+            }
+            else {
+                visited[current] = 2;
+                postOrder.push_back(current);
+                path.pop_back();
+            }
+        }
+    }
+    return vector<int>(postOrder.rbegin(), postOrder.rend());
+}
+
+// Plan
+// Aggregates the demand in topological order and emits the crafts
+executableplan productionplanner::Plan(const stockpile& bill,
+                                       const stockpile& resources) {
+    nodes.clear();
+    nodeIds.clear();
+
+    vector<int> targets;
+    bill.ForEachResource([&](const string& material, double quantity) {
+        if (quantity > 0) {
+            int id = Intern(material, resources);
+            nodes[id].demand += quantity;
+            targets.push_back(id);
+        }
+    });
+    sort(targets.begin(), targets.end());
+
+    vector<int> order = Order(targets, resources);
+
+    for (size_t i = 0; i < order.size(); i++) {
+        node& current = nodes[order[i]];
+        double used = min(current.stock, current.demand);
+        current.stock -= used;
+        double shortfall = current.demand - used;
+        if (shortfall <= EPSILON) {
+            continue;
+        }
+        if (current.producer < 0 || current.yield <= 0) {
+            throw runtime_error("There is no recipe for " + current.material
+                                + ".");
+        }
+
+        current.crafts = (long long) ceil(shortfall / current.yield - EPSILON);
+        for (const pair<int, int>& input : current.inputs) {
+            double needed = (double) current.crafts * input.second;
+            nodes[input.first].demand += needed;
+        }
+    }
+
+    executableplan result;
+    for (auto step = order.rbegin(); step != order.rend(); ++step) {
+        const node& current = nodes[*step];
+        for (long long c = 0; c < current.crafts; c++) {
+            result.Add(formula(catalog->QueryFormula(current.producer)));
+        }
+    }
+    return result;
+}
+
+// Query Demand
+double productionplanner::QueryDemand(const string& material) const {
+    auto item = nodeIds.find(material);
+    return item == nodeIds.end() ? 0 : nodes[item->second].demand;
+}
+
+// Query Crafts
+long long productionplanner::QueryCrafts(const string& material) const {
+    auto item = nodeIds.find(material);
+    return item == nodeIds.end() ? 0 : nodes[item->second].crafts;
+}
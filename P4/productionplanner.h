@@ -0,0 +1,80 @@
+// AUTHOR:      Hongru He
+// FILENAME:    productionplanner.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_PRODUCTIONPLANNER_H
+#define P4_PRODUCTIONPLANNER_H
+#include "craftabilitysolver.h"
+#include "executableplan.h"
+#include "recipecatalog.h"
+#include "stockpile.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The ProductionPlanner class turns a bill of materials into an
+// ExecutablePlan by backward chaining: whatever the Stockpile lacks is
+// crafted, and whatever those crafts lack is crafted first.
+// Class Invariants:
+// 1.   Every material is produced by one recipe, the one with the lowest id
+//      in the catalog, and the demand of all its consumers is added up
+//      before it is exploded, so shared subcomponents are planned once.
+// 2.   The emitted plan lists every craft after the crafts of its inputs.
+// 3.   A chosen producer that needs its own output, directly or through
+//      other producers, raises a runtime_error naming the cycle.
+
+class productionplanner {
+private:
+    struct node {
+        string material;
+        double stock = 0;
+        double demand = 0;
+        long long crafts = 0;
+        double yield = 0;
+        int producer = -1;
+        vector<pair<int, int>> inputs;
+    };
+
+    const recipecatalog* catalog;
+    yieldmode mode;
+    vector<node> nodes;
+    unordered_map<string, int> nodeIds;
+
+    int Intern(const string&, const stockpile&);
+    // Get the node of a material, choosing its producer when it is new
+
+    vector<int> Order(const vector<int>&, const stockpile&);
+    // List every material the targets depend on, consumers first
+
+    void ThrowCycle(const vector<pair<int, int>>&, int) const;
+    // Raise the runtime_error for a cycle that closes at a path node
+
+public:
+    explicit productionplanner(const recipecatalog&,
+                               yieldmode = yieldmode::Nominal);
+    // Overloaded Constructor
+    // Explanation:     Initializes a ProductionPlanner over a catalog.
+    // Precondition:    The catalog outlives the planner.
+    // Postcondition:   ProductionPlanner object is ready to plan.
+
+    executableplan Plan(const stockpile&, const stockpile&);
+    // Plan the crafts for a bill of materials
+    // Explanation:     The first Stockpile is the bill, the second the
+    //                  resources at hand. Each craft is one step.
+    // Precondition:    None.
+    // Postcondition:   Return the plan; a runtime_error is thrown if a
+    //                  material has no recipe or needs itself.
+
+    double QueryDemand(const string&) const;
+    // Get the total demand for a material in the last plan
+
+    long long QueryCrafts(const string&) const;
+    // Get how many crafts of a material's recipe the last plan holds
+};
+
+
+#endif //P4_PRODUCTIONPLANNER_H
@@ -0,0 +1,167 @@
+// AUTHOR:      Hongru He
+// FILENAME:    recipe.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_RECIPE_H
+#define P4_RECIPE_H
+#include "executableplan.h"
+#include "formula.h"
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+
+using namespace std;
+
+// The Recipe and RecipePlan class templates declare formulas and whole plans
+// at compile time:
+//     constexpr auto water = MakeRecipe({{"Oxygen", 2}, {"Hydrogen", 1}},
+//                                       {{"Water", 1}});
+//     constexpr auto plan = MakePlan(water, cookie);
+// Class Invariants:
+// 1.   A Recipe has at least one input and one output, and every material
+//      has a name and a positive number. A constexpr Recipe that breaks this
+//      does not compile.
+// 2.   Recipes only refer to string literals, so constexpr Recipes and
+//      RecipePlans live in read-only data and cost nothing at startup.
+
+// One material of a Recipe with its number.
+struct recipeitem {
+    string_view material;
+    int number;
+};
+
+template <size_t In, size_t Out>
+class recipe {
+    static_assert(In > 0 && Out > 0,
+                  "A recipe needs at least one input and one output.");
+
+private:
+    array<recipeitem, In> inputs;
+    array<recipeitem, Out> outputs;
+
+    // Validate one side of the recipe; throwing during constant evaluation
+    // turns an invalid constexpr Recipe into a compile error.
+    template <size_t N>
+    static constexpr array<recipeitem, N> Validate(
+            const recipeitem (&items)[N]) {
+        array<recipeitem, N> checked{};
+        for (size_t i = 0; i < N; i++) {
+            if (items[i].material.empty()) {
+                throw invalid_argument("A recipe material needs a name.");
+            }
+            if (items[i].number <= 0) {
+                throw invalid_argument("A recipe number must be positive.");
+            }
+            checked[i] = items[i];
+        }
+        return checked;
+    }
+
+public:
+    // Overloaded Constructor
+    // Explanation:     Initializes a Recipe with its inputs and outputs.
+    // Precondition:    Every material has a name and a positive number;
+    //                  otherwise an invalid_argument exception is thrown, or
+    //                  compiling fails for a constexpr Recipe.
+    // Postcondition:   Recipe object holds the validated materials.
+    constexpr recipe(const recipeitem (&in)[In], const recipeitem (&out)[Out])
+            : inputs(Validate(in)), outputs(Validate(out)) {}
+
+    // Get an input material and its number
+    constexpr const recipeitem& QueryInput(size_t index) const {
+        return inputs[index];
+    }
+
+    // Get an output material and its number
+    constexpr const recipeitem& QueryOutput(size_t index) const {
+        return outputs[index];
+    }
+
+    static constexpr size_t QueryInputSize() {
+        return In;
+    }
+
+    static constexpr size_t QueryOutputSize() {
+        return Out;
+    }
+
+    // Build a Formula from the Recipe
+    // Explanation:     Allocates the arrays a Formula owns and copies the
+    //                  materials into them.
+    // Precondition:    None.
+    // Postcondition:   Return a new Formula with the Recipe's materials.
+    formula ToFormula() const {
+        string* inputMaterial = new string[In];
+        int* inputNumber = new int[In];
+        for (size_t i = 0; i < In; i++) {
+            inputMaterial[i] = string(inputs[i].material);
+            inputNumber[i] = inputs[i].number;
+        }
+
+        string* outputMaterial = new string[Out];
+        int* outputNumber = new int[Out];
+        for (size_t j = 0; j < Out; j++) {
+            outputMaterial[j] = string(outputs[j].material);
+            outputNumber[j] = outputs[j].number;
+        }
+
+        return formula(inputMaterial, inputNumber, In, outputMaterial,
+                       outputNumber, Out);
+    }
+};
+
+// Declare a Recipe from braced lists of inputs and outputs
+template <size_t In, size_t Out>
+constexpr recipe<In, Out> MakeRecipe(const recipeitem (&in)[In],
+                                     const recipeitem (&out)[Out]) {
+    return recipe<In, Out>(in, out);
+}
+
+template <typename... Recipes>
+class recipeplan {
+    static_assert(sizeof...(Recipes) > 0, "A plan needs at least one recipe.");
+
+private:
+    tuple<Recipes...> steps;
+
+public:
+    // Overloaded Constructor
+    // Explanation:     Initializes a RecipePlan with its steps in order.
+    constexpr explicit recipeplan(const Recipes&... recipes)
+            : steps(recipes...) {}
+
+    // Get the number of steps
+    static constexpr size_t QuerySize() {
+        return sizeof...(Recipes);
+    }
+
+    // Get the Recipe of a step
+    template <size_t Index>
+    constexpr const auto& QueryStep() const {
+        return get<Index>(steps);
+    }
+
+    // Build an ExecutablePlan from the RecipePlan
+    // Explanation:     Adds a Formula for every step, in order.
+    // Precondition:    None.
+    // Postcondition:   Return a new ExecutablePlan at its first step.
+    executableplan ToExecutablePlan() const {
+        executableplan result;
+        apply([&result](const Recipes&... recipes) {
+            (result.Add(recipes.ToFormula()), ...);
+        }, steps);
+        return result;
+    }
+};
+
+// Declare a RecipePlan from Recipes in step order
+template <typename... Recipes>
+constexpr recipeplan<Recipes...> MakePlan(const Recipes&... recipes) {
+    return recipeplan<Recipes...>(recipes...);
+}
+
+
+#endif //P4_RECIPE_H
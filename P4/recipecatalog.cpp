@@ -0,0 +1,77 @@
+// AUTHOR:      Hongru He
+// FILENAME:    recipecatalog.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "recipecatalog.h"
+#include <stdexcept>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   recipes[id] holds the recipe with that id; a removed recipe stays in
+//      place with removed[id] set, so the ids of later recipes never move.
+// 2.   recipeCount is the number of ids whose removed flag is not set.
+
+// Default Constructor
+recipecatalog::recipecatalog() {
+    recipeCount = 0;
+}
+
+// Add
+// Stores the Formula under the next id and indexes it
+int recipecatalog::Add(formula&& newFor) {
+    int id = (int) recipes.size();
+    recipes.push_back(std::move(newFor));
+    removed.push_back(false);
+    index.Insert(id, recipes.back());
+    recipeCount++;
+    return id;
+}
+
+// Remove
+// Drops the recipe from the index and marks its id as removed
+void recipecatalog::Remove(int id) {
+    if (!QueryContains(id)) {
+        throw out_of_range("There is no recipe with this id.");
+    }
+    index.Erase(id, recipes[id]);
+    recipes[id] = formula();
+    removed[id] = true;
+    recipeCount--;
+}
+
+// Query Formula
+const formula& recipecatalog::QueryFormula(int id) const {
+    if (!QueryContains(id)) {
+        throw out_of_range("There is no recipe with this id.");
+    }
+    return recipes[id];
+}
+
+// Query Contains
+bool recipecatalog::QueryContains(int id) const {
+    return id >= 0 && id < (int) recipes.size() && !removed[id];
+}
+
+// Query Size
+int recipecatalog::QuerySize() const {
+    return recipeCount;
+}
+
+// Query Id Limit
+int recipecatalog::QueryIdLimit() const {
+    return (int) recipes.size();
+}
+
+// Query Producers
+const vector<int>& recipecatalog::QueryProducers(const string& material)
+        const {
+    return index.QueryProducers(material);
+}
+
+// Query Consumers
+const vector<int>& recipecatalog::QueryConsumers(const string& material)
+        const {
+    return index.QueryConsumers(material);
+}
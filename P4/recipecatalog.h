@@ -0,0 +1,72 @@
+// AUTHOR:      Hongru He
+// FILENAME:    recipecatalog.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_RECIPECATALOG_H
+#define P4_RECIPECATALOG_H
+#include "formula.h"
+#include "materialindex.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The RecipeCatalog class holds every known Formula under a stable id and
+// answers which recipes produce or consume a material.
+// Class Invariants:
+// 1.   Ids are assigned in order and never reused, so an id stays valid
+//      until its recipe is removed.
+// 2.   The MaterialIndex always holds exactly the recipes in the catalog.
+
+class recipecatalog {
+private:
+    vector<formula> recipes;
+    vector<bool> removed;
+    materialindex index;
+    int recipeCount;
+
+public:
+    recipecatalog();
+    // Default Constructor
+    // Explanation:     Initializes an empty RecipeCatalog.
+    // Precondition:    None.
+    // Postcondition:   RecipeCatalog object is initialized with no recipes.
+
+    int Add(formula&&);
+    // Add a recipe to the catalog
+    // Explanation:     Takes over the Formula and indexes its materials.
+    // Precondition:    the parameter is a valid, constructed Formula object.
+    // Postcondition:   Return the id of the new recipe.
+
+    void Remove(int);
+    // Remove a recipe from the catalog
+    // Explanation:     Drops the recipe from the index; its id is not
+    //                  reused.
+    // Precondition:    The id names a recipe in the catalog; otherwise an
+    //                  out_of_range exception is thrown.
+    // Postcondition:   The recipe is no longer in the catalog.
+
+    const formula& QueryFormula(int) const;
+    // Get a recipe by its id
+    // Precondition:    The id names a recipe in the catalog; otherwise an
+    //                  out_of_range exception is thrown.
+
+    bool QueryContains(int) const;
+    // Check if an id names a recipe in the catalog
+
+    int QuerySize() const;
+    // Get the number of recipes in the catalog
+
+    int QueryIdLimit() const;
+    // Get the number just past the largest id ever assigned
+
+    const vector<int>& QueryProducers(const string&) const;
+    // Get the ids of the recipes that produce a material
+
+    const vector<int>& QueryConsumers(const string&) const;
+    // Get the ids of the recipes that consume a material
+};
+
+
+#endif //P4_RECIPECATALOG_H
@@ -0,0 +1,286 @@
+// AUTHOR:      Hongru He
+// FILENAME:    recipematrix.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "recipematrix.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Rows are materials, so a product only writes stock[row] for the rows
+//      of its own range; threads never write the same entry.
+// 2.   Row ranges are cut at equal shares of the stored entries, which is
+//      where the work is, rather than at equal numbers of rows.
+// 3.   Small products run on the calling thread, where starting threads
+//      would cost more than the product.
+
+namespace {
+    // Products with fewer stored entries than this run on one thread.
+    const size_t PARALLELENTRIES = 1 << 16;
+    const double EPSILON = 1e-9;
+}
+
+// Overloaded Constructor
+// Collects the entries of every recipe and builds both matrices
+recipematrix::recipematrix(const recipecatalog& recipes, yieldmode mode,
+                           bool consume) {
+    consuming = consume;
+    for (int id = 0; id < recipes.QueryIdLimit(); id++) {
+        if (recipes.QueryContains(id)) {
+            recipeIds.push_back(id);
+        }
+    }
+
+    vector<pair<long long, double>> consumed;
+    vector<pair<long long, double>> produced;
+    long long columns = (long long) recipeIds.size();
+    for (int j = 0; j < (int) recipeIds.size(); j++) {
+        const formula& recipe = recipes.QueryFormula(recipeIds[j]);
+        double yield = craftabilitysolver::QueryYield(recipe, mode);
+        for (int i = 0; i < recipe.QueryInputSize(); i++) {
+            int row = Intern(recipe.QueryInputMaterial(i));
+            consumed.push_back({row * columns + j,
+                                (double) recipe.QueryInputNumber(i)});
+            if (consuming) {
+                produced.push_back({row * columns + j,
+                                    -(double) recipe.QueryInputNumber(i)});
+            }
+        }
+        for (int k = 0; k < recipe.QueryOutputSize(); k++) {
+            int row = Intern(recipe.QueryOutputMaterial(k));
+            produced.push_back({row * columns + j,
+                                yield * recipe.QueryOutputNumber(k)});
+        }
+    }
+
+    Build(consumption, consumed, (int) materials.size(), (int) columns);
+    Build(net, produced, (int) materials.size(), (int) columns);
+}
+
+// Intern
+int recipematrix::Intern(const string& material) {
+    auto item = rows.find(material);
+    if (item != rows.end()) {
+        return item->second;
+    }
+    int row = (int) materials.size();
+    rows.emplace(material, row);
+    materials.push_back(material);
+    return row;
+}
+
+// Build
+// Sorts the entries by position, merges duplicates and fills the CSR arrays
+void recipematrix::Build(csr& matrix, vector<pair<long long, double>>& entries,
+                         int rowCount, int columnCount) {
+    sort(entries.begin(), entries.end(),
+         [](const pair<long long, double>& a, const pair<long long, double>& b) {
+             return a.first < b.first;
+         });
+
+    matrix.rowStart.assign(rowCount + 1, 0);
+    matrix.column.clear();
+    matrix.value.clear();
+    for (size_t e = 0; e < entries.size(); e++) {
+        if (e > 0 && entries[e].first == entries[e - 1].first) {
+            matrix.value.back() += entries[e].second;
+            continue;
+        }
+        int row = (int) (entries[e].first / columnCount);
+        matrix.column.push_back((int) (entries[e].first % columnCount));
+        matrix.value.push_back(entries[e].second);
+        matrix.rowStart[row + 1]++;
+    }
+    for (int r = 0; r < rowCount; r++) {
+        matrix.rowStart[r + 1] += matrix.rowStart[r];
+    }
+}
+
+// For Row Ranges
+// Cuts the rows at equal shares of the entries and runs each range
+template <typename Function>
+void recipematrix::ForRowRanges(int threadCount,
+                                const Function& function) const {
+    int rowCount = (int) materials.size();
+    size_t entries = net.value.size() + consumption.value.size();
+    if (threadCount <= 0) {
+        threadCount = max(1, (int) thread::hardware_concurrency());
+    }
+    if (entries < PARALLELENTRIES || threadCount == 1 || rowCount < 2) {
+        function(0, rowCount);
+        return;
+    }
+    threadCount = min(threadCount, rowCount);
+
+    vector<int> cut(threadCount + 1, rowCount);
+    cut[0] = 0;
+    size_t share = (net.value.size() + threadCount - 1) / threadCount;
+    int row = 0;
+    for (int t = 1; t < threadCount; t++) {
+        while (row < rowCount && net.rowStart[row] < t * share) {
+            row++;
+        }
+        cut[t] = row;
+    }
+
+    vector<thread> workers;
+    for (int t = 1; t < threadCount; t++) {
+        if (cut[t] < cut[t + 1]) {
+            workers.emplace_back([&function, &cut, t]() {
+                function(cut[t], cut[t + 1]);
+            });
+        }
+    }
+    function(cut[0], cut[1]);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Query Material Count
+int recipematrix::QueryMaterialCount() const {
+    return (int) materials.size();
+}
+
+// Query Recipe Count
+int recipematrix::QueryRecipeCount() const {
+    return (int) recipeIds.size();
+}
+
+// Query Row
+int recipematrix::QueryRow(const string& material) const {
+    auto item = rows.find(material);
+    return item == rows.end() ? -1 : item->second;
+}
+
+// Query Material
+const string& recipematrix::QueryMaterial(int row) const {
+    if (row < 0 || row >= (int) materials.size()) {
+        throw out_of_range("Row out of range.");
+    }
+    return materials[row];
+}
+
+// Query Recipe Id
+int recipematrix::QueryRecipeId(int column) const {
+    if (column < 0 || column >= (int) recipeIds.size()) {
+        throw out_of_range("Column out of range.");
+    }
+    return recipeIds[column];
+}
+
+// Query the CSR arrays of the net matrix
+const vector<size_t>& recipematrix::QueryRowStart() const {
+    return net.rowStart;
+}
+
+const vector<int>& recipematrix::QueryColumns() const {
+    return net.column;
+}
+
+const vector<double>& recipematrix::QueryValues() const {
+    return net.value;
+}
+
+// Gather
+vector<double> recipematrix::Gather(const stockpile& resources) const {
+    vector<double> result(materials.size(), 0);
+    resources.ForEachResource([this, &result](const string& name,
+                                              double quantity) {
+        auto item = rows.find(name);
+        if (item != rows.end()) {
+            result[item->second] = quantity;
+        }
+    });
+    return result;
+}
+
+// Scatter
+void recipematrix::Scatter(const vector<double>& stock,
+                           stockpile& resources) const {
+    vector<double> current = Gather(resources);
+    for (size_t row = 0; row < materials.size(); row++) {
+        double delta = stock[row] - current[row];
+        if (delta != 0) {
+            resources.IncreaseResource(materials[row], delta);
+        }
+    }
+}
+
+// Check Feasible
+// Computes C * counts, or the largest input of a recipe in the batch if
+// inputs are only checked, one row range per thread and compares with the
+// stock
+bool recipematrix::CheckFeasible(const vector<double>& counts,
+                                 const vector<double>& stock,
+                                 int threadCount) const {
+    if (counts.size() != recipeIds.size() ||
+        stock.size() != materials.size()) {
+        throw invalid_argument("Vector sizes do not match the matrix.");
+    }
+    for (double count : counts) {
+        if (count < 0) {
+            throw invalid_argument("Craft counts cannot be negative.");
+        }
+    }
+
+    atomic<bool> feasible{true};
+    ForRowRanges(threadCount, [&](int first, int last) {
+        const size_t* start = consumption.rowStart.data();
+        const int* column = consumption.column.data();
+        const double* value = consumption.value.data();
+        for (int row = first; row < last; row++) {
+            double needed = 0;
+            for (size_t e = start[row]; e < start[row + 1]; e++) {
+                if (consuming) {
+                    needed += value[e] * counts[column[e]];
+                }
+                else if (counts[column[e]] > 0) {
+                    needed = max(needed, value[e]);
+                }
+            }
+            if (needed > stock[row] + EPSILON) {
+                feasible.store(false, memory_order_relaxed);
+                return;
+            }
+        }
+    });
+    return feasible.load();
+}
+
+// Apply
+// Adds the net matrix times the counts to the stock, one row range per
+// thread
+void recipematrix::Apply(const vector<double>& counts, vector<double>& stock,
+                         int threadCount) const {
+    if (!CheckFeasible(counts, stock, threadCount)) {
+        throw runtime_error("Insufficient resources to apply the batch.");
+    }
+
+    ForRowRanges(threadCount, [&](int first, int last) {
+        const size_t* start = net.rowStart.data();
+        const int* column = net.column.data();
+        const double* value = net.value.data();
+        for (int row = first; row < last; row++) {
+            double change = 0;
+            for (size_t e = start[row]; e < start[row + 1]; e++) {
+                change += value[e] * counts[column[e]];
+            }
+            stock[row] += change;
+        }
+    });
+}
+
+// Apply
+// Runs the batch on a dense copy of the Stockpile
+void recipematrix::Apply(const vector<double>& counts, stockpile& resources,
+                         int threadCount) const {
+    vector<double> stock = Gather(resources);
+    Apply(counts, stock, threadCount);
+    Scatter(stock, resources);
+}
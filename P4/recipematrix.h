@@ -0,0 +1,134 @@
+// AUTHOR:      Hongru He
+// FILENAME:    recipematrix.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_RECIPEMATRIX_H
+#define P4_RECIPEMATRIX_H
+#include "craftabilitysolver.h"
+#include "recipecatalog.h"
+#include "stockpile.h"
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// The RecipeMatrix class compiles a RecipeCatalog into sparse matrices with
+// one row per material and one column per recipe, so crafting every recipe
+// j counts[j] times is a single matrix-vector product on a dense vector of
+// quantities:
+//     stock += N * counts
+// where C holds the input numbers, P the output numbers, and the net matrix
+// N is yield * P. Like ExecutablePlan::Apply, a craft only checks its
+// inputs by default, so a batch gives the same stock as running its crafts
+// as steps. A consuming matrix uses N = yield * P - C instead.
+// Class Invariants:
+// 1.   Columns follow the catalog ids in increasing order; the catalog may
+//      change afterwards without affecting a compiled matrix.
+// 2.   Both matrices are stored in CSR form, with the entries of a row
+//      sorted by column and a material listed at most once per recipe.
+// 3.   A batch is feasible when the starting stock holds every input of
+//      every recipe in it with a positive count. A consuming batch needs
+//      the starting stock to cover the inputs of all its crafts, as if they
+//      consumed their inputs before any of them produced.
+
+class recipematrix {
+private:
+    struct csr {
+        vector<size_t> rowStart;
+        vector<int> column;
+        vector<double> value;
+    };
+
+    vector<string> materials;
+    unordered_map<string, int> rows;
+    vector<int> recipeIds;
+    csr consumption;
+    csr net;
+    bool consuming = false;
+
+    int Intern(const string&);
+    // Get the row of a material, adding a new row if necessary
+
+    static void Build(csr&, vector<pair<long long, double>>&, int, int);
+    // Build a CSR matrix with the given rows and columns from
+    // (row * columns + column, value) entries
+
+    template <typename Function>
+    void ForRowRanges(int, const Function&) const;
+    // Split the rows into ranges of similar work and run the function on
+    // each range, on up to the given number of threads
+
+public:
+    explicit recipematrix(const recipecatalog&,
+                          yieldmode = yieldmode::Nominal, bool = false);
+    // Overloaded Constructor
+    // Explanation:     Compiles every recipe in the catalog; outputs are
+    //                  scaled by the recipe's yield under the mode. Crafts
+    //                  consume their inputs only if the flag is set.
+    // Precondition:    None.
+    // Postcondition:   RecipeMatrix object holds both matrices.
+
+    int QueryMaterialCount() const;
+    // Get the number of rows
+
+    int QueryRecipeCount() const;
+    // Get the number of columns
+
+    int QueryRow(const string&) const;
+    // Get the row of a material, or -1 if no recipe uses it
+
+    const string& QueryMaterial(int) const;
+    // Get the material of a row
+
+    int QueryRecipeId(int) const;
+    // Get the catalog id of the recipe in a column
+
+    const vector<size_t>& QueryRowStart() const;
+    const vector<int>& QueryColumns() const;
+    const vector<double>& QueryValues() const;
+    // Get the CSR arrays of the net matrix
+
+    vector<double> Gather(const stockpile&) const;
+    // Read a Stockpile into a dense vector with one entry per row
+    // Explanation:     Materials that are missing count as 0; materials no
+    //                  recipe uses are left out.
+
+    void Scatter(const vector<double>&, stockpile&) const;
+    // Write a dense vector back into a Stockpile
+    // Explanation:     Changes each material by the difference to the
+    //                  vector, so watchers and logs see one delta per
+    //                  changed material.
+
+    bool CheckFeasible(const vector<double>&, const vector<double>&,
+                       int = 0) const;
+    // Check if a batch of crafts can run
+    // Explanation:     The first vector holds the count of every column,
+    //                  the second the dense stock. Runs on the given number
+    //                  of threads; 0 uses every hardware thread.
+    // Precondition:    Both vectors have the matrix's sizes and no count is
+    //                  negative; otherwise an invalid_argument exception is
+    //                  thrown.
+    // Postcondition:   Return true if the stock holds every input, or
+    //                  covers them all for a consuming matrix.
+
+    void Apply(const vector<double>&, vector<double>&, int = 0) const;
+    // Run a batch of crafts on a dense stock
+    // Explanation:     Adds the net matrix times the counts to the stock.
+    // Precondition:    The batch is feasible; otherwise a runtime_error is
+    //                  thrown and the stock is not modified.
+    // Postcondition:   The stock holds the quantities after the batch.
+
+    void Apply(const vector<double>&, stockpile&, int = 0) const;
+    // Run a batch of crafts on a Stockpile
+    // Explanation:     Gathers the Stockpile, applies the batch and
+    //                  scatters the result back.
+    // Precondition:    The batch is feasible; otherwise a runtime_error is
+    //                  thrown and the Stockpile is not modified.
+    // Postcondition:   The Stockpile holds the quantities after the batch.
+};
+
+
+#endif //P4_RECIPEMATRIX_H
@@ -0,0 +1,237 @@
+// AUTHOR:      Hongru He
+// FILENAME:    replanner.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "replanner.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Materials are interned to indices in a deque, so references to them
+//      stay valid while recursion interns more.
+// 2.   Working quantities are read from the Stockpile the first time a
+//      repair touches a material; every later change is logged in undo, so
+//      a recipe that fails halfway is rolled back exactly.
+// 3.   crafts lists the inserted recipes in the order they run; the crafts
+//      of inputs come before the craft that needs them.
+// 4.   The catalog's size and id limit are remembered with the routes; any
+//      Add or Remove changes one of them and the routes are dropped.
+// 5.   Unless consuming, a step or craft only checks that its inputs are
+//      present, so the working quantities only ever grow.
+
+namespace {
+    const double EPSILON = 1e-9;
+}
+
+// Overloaded Constructor
+replanner::replanner(const recipecatalog& recipes, yieldmode yieldMode) {
+    catalog = &recipes;
+    mode = yieldMode;
+    Invalidate();
+}
+
+// Intern
+int replanner::Intern(const string& name) {
+    auto item = materialIds.find(name);
+    if (item != materialIds.end()) {
+        return item->second;
+    }
+    int id = (int) materials.size();
+    materialIds.emplace(name, id);
+    materials.emplace_back();
+    materials[id].name = name;
+    return id;
+}
+
+// Quantity
+double& replanner::Quantity(int id) {
+    material& current = materials[id];
+    if (!current.loaded) {
+        current.quantity = max(resources->QueryQuantity(current.name), 0);
+        current.loaded = true;
+        loaded.push_back(id);
+    }
+    return current.quantity;
+}
+
+// Change
+void replanner::Change(int id, double delta) {
+    double& quantity = Quantity(id);
+    undo.push_back({id, quantity});
+    quantity += delta;
+}
+
+// Route
+// Looks up the producers once; recipes that yield nothing are skipped
+const vector<replanner::option>& replanner::Route(int id) {
+    if (materials[id].routed) {
+        return materials[id].options;
+    }
+
+    vector<int> producers = catalog->QueryProducers(materials[id].name);
+    sort(producers.begin(), producers.end());
+    vector<option> options;
+    for (int producer : producers) {
+        const formula& recipe = catalog->QueryFormula(producer);
+        double factor = craftabilitysolver::QueryYield(recipe, mode);
+        option choice;
+        choice.recipe = producer;
+        choice.yield = 0;
+        for (int j = 0; j < recipe.QueryOutputSize(); j++) {
+            int output = Intern(recipe.QueryOutputMaterial(j));
+            choice.outputs.push_back({output, recipe.QueryOutputNumber(j)});
+            if (output == id) {
+                choice.yield += recipe.QueryOutputNumber(j) * factor;
+            }
+        }
+        if (choice.yield <= 0) {
+            continue;
+        }
+        for (int i = 0; i < recipe.QueryInputSize(); i++) {
+            choice.inputs.push_back({Intern(recipe.QueryInputMaterial(i)),
+                                     recipe.QueryInputNumber(i)});
+        }
+        options.push_back(std::move(choice));
+    }
+
+    materials[id].options = std::move(options);
+    materials[id].routed = true;
+    return materials[id].options;
+}
+
+// Supply
+// Tries the producers in catalog order and keeps the first that works
+bool replanner::Supply(int id, double amount) {
+    if (Quantity(id) + EPSILON >= amount) {
+        return true;
+    }
+    if (materials[id].visiting) {
+        return false;
+    }
+
+    materials[id].visiting = true;
+    for (const option& choice : Route(id)) {
+        double deficit = amount - Quantity(id);
+        long long count = (long long) ceil(deficit / choice.yield - EPSILON);
+        size_t undoMark = undo.size();
+        size_t craftMark = crafts.size();
+
+        // Unconsumed inputs only have to be present once for all crafts
+        bool supplied = true;
+        for (const pair<int, int>& input : choice.inputs) {
+            double needed = consuming ? (double) count * input.second :
+                            input.second;
+            if (!Supply(input.first, needed)) {
+                supplied = false;
+                break;
+            }
+            if (consuming) {
+                Change(input.first, -needed);
+            }
+        }
+
+        if (supplied) {
+            double factor = craftabilitysolver::QueryYield(
+                    catalog->QueryFormula(choice.recipe), mode);
+            for (const pair<int, int>& output : choice.outputs) {
+                Change(output.first, (double) count * output.second * factor);
+            }
+            crafts.insert(crafts.end(), (size_t) count, choice.recipe);
+            materials[id].visiting = false;
+            return true;
+        }
+
+        while (undo.size() > undoMark) {
+            materials[undo.back().first].quantity = undo.back().second;
+            undo.pop_back();
+        }
+        crafts.resize(craftMark);
+    }
+    materials[id].visiting = false;
+    return false;
+}
+
+// Repair
+// Simulates the suffix once and rewrites it from the first insertion on
+int replanner::Repair(executableplan& target, const stockpile& stock,
+                      bool consume) {
+    if (catalog->QuerySize() != catalogSize ||
+        catalog->QueryIdLimit() != catalogIdLimit) {
+        Invalidate();
+    }
+    resources = &stock;
+    consuming = consume;
+    for (int id : loaded) {
+        materials[id].loaded = false;
+    }
+    loaded.clear();
+    crafts.clear();
+
+    // The step each batch of crafts runs before, and where the batch ends
+    vector<pair<int, size_t>> insertions;
+    int size = target.QuerySize();
+    for (int s = target.QueryCurrentIndex(); s < size; s++) {
+        const formula& step = target.QueryFormula(s);
+        size_t before = crafts.size();
+        undo.clear();
+        for (int i = 0; i < step.QueryInputSize(); i++) {
+            int input = Intern(step.QueryInputMaterial(i));
+            if (!Supply(input, step.QueryInputNumber(i))) {
+                throw runtime_error("Step " + to_string(s + 1) +
+                                    " cannot be repaired: there is not "
+                                    "enough " + materials[input].name + ".");
+            }
+            if (consuming) {
+                Change(input, -step.QueryInputNumber(i));
+            }
+        }
+        double factor = craftabilitysolver::QueryYield(step, mode);
+        for (int j = 0; j < step.QueryOutputSize(); j++) {
+            Change(Intern(step.QueryOutputMaterial(j)),
+                   step.QueryOutputNumber(j) * factor);
+        }
+        if (crafts.size() > before) {
+            insertions.push_back({s, crafts.size()});
+        }
+    }
+    if (insertions.empty()) {
+        return 0;
+    }
+
+    vector<formula> suffix;
+    size_t craft = 0;
+    size_t batch = 0;
+    int first = insertions[0].first;
+    for (int s = first; s < size; s++) {
+        if (batch < insertions.size() && insertions[batch].first == s) {
+            for (; craft < insertions[batch].second; craft++) {
+                suffix.push_back(catalog->QueryFormula(crafts[craft]));
+            }
+            batch++;
+        }
+        suffix.push_back(target.QueryFormula(s));
+    }
+    for (size_t k = 0; k < suffix.size(); k++) {
+        int index = first + (int) k;
+        if (index < size) {
+            target.Replace(std::move(suffix[k]), index);
+        }
+        else {
+            target.Add(std::move(suffix[k]));
+        }
+    }
+    return (int) crafts.size();
+}
+
+// Invalidate
+void replanner::Invalidate() {
+    materials.clear();
+    materialIds.clear();
+    loaded.clear();
+    catalogSize = catalog->QuerySize();
+    catalogIdLimit = catalog->QueryIdLimit();
+}
@@ -0,0 +1,104 @@
+// AUTHOR:      Hongru He
+// FILENAME:    replanner.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_REPLANNER_H
+#define P4_REPLANNER_H
+#include "craftabilitysolver.h"
+#include "executableplan.h"
+#include "recipecatalog.h"
+#include "stockpile.h"
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The Replanner class repairs a running ExecutablePlan after a step failed
+// or the Stockpile changed. It walks the steps from the cursor with the
+// current resources and, before any step whose inputs fall short, inserts
+// the crafts that make up the shortfall, retrying the same recipe or
+// falling back to another recipe for the material.
+// Class Invariants:
+// 1.   Steps before the cursor are never touched, and neither are the steps
+//      before the first inserted craft.
+// 2.   The recipes a material can be crafted from are looked up once and
+//      kept across repairs until the catalog changes.
+// 3.   A repair that cannot cover a shortfall leaves the plan unchanged and
+//      raises a runtime_error.
+
+class replanner {
+private:
+    struct option {
+        int recipe;
+        double yield;
+        vector<pair<int, int>> inputs;
+        vector<pair<int, int>> outputs;
+    };
+
+    struct material {
+        string name;
+        bool routed = false;
+        vector<option> options;
+        double quantity = 0;
+        bool loaded = false;
+        bool visiting = false;
+    };
+
+    const recipecatalog* catalog;
+    yieldmode mode;
+    int catalogSize = -1;
+    int catalogIdLimit = -1;
+    deque<material> materials;
+    unordered_map<string, int> materialIds;
+
+    const stockpile* resources = nullptr;
+    bool consuming = false;
+    vector<int> loaded;
+    vector<pair<int, double>> undo;
+    vector<int> crafts;
+
+    int Intern(const string&);
+    // Get the index of a material
+
+    double& Quantity(int);
+    // Get the working quantity of a material, reading the Stockpile once
+
+    void Change(int, double);
+    // Change a working quantity so it can be rolled back
+
+    const vector<option>& Route(int);
+    // Get the recipes that produce a material, in catalog order
+
+    bool Supply(int, double);
+    // Insert the crafts that bring a material up to the quantity
+
+public:
+    explicit replanner(const recipecatalog&, yieldmode = yieldmode::Nominal);
+    // Overloaded Constructor
+    // Explanation:     Initializes a Replanner over a catalog.
+    // Precondition:    The catalog outlives the replanner.
+    // Postcondition:   Replanner object is ready to repair plans.
+
+    int Repair(executableplan&, const stockpile&, bool = false);
+    // Repair the remaining steps of a plan
+    // Explanation:     Each step adds its outputs at the yield of the mode.
+    //                  By default a step only needs its inputs to be
+    //                  present, as ExecutablePlan::Apply checks them without
+    //                  consuming them; if the flag is set, steps and crafts
+    //                  consume their inputs. Crafts are inserted right
+    //                  before the first step that would run short.
+    // Precondition:    The Stockpile holds the resources at the cursor.
+    // Postcondition:   Return the number of inserted crafts; a
+    //                  runtime_error is thrown, and the plan is unchanged,
+    //                  if a shortfall has no recipe or only a cyclic one.
+
+    void Invalidate();
+    // Forget the recipes looked up so far
+};
+
+
+#endif //P4_REPLANNER_H
@@ -0,0 +1,392 @@
+// AUTHOR:      Hongru He
+// FILENAME:    resourcemap.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "resourcemap.h"
+#include <functional>
+#include <stdexcept>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define P4_RESOURCEMAP_SSE2
+#endif
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   The high bits of the hash choose the first group and the low 7 bits
+//      are stored in the control byte, so a group of 16 slots is filtered
+//      with one SSE2 compare before any key is touched.
+// 2.   Groups are visited in triangular order, which reaches every group of
+//      a power-of-two table, and a group holding an EMPTY byte ends the
+//      search because no key was ever placed past it.
+// 3.   Growth happens before the probe of an insertion, so one probe both
+//      looks the key up and finds its slot.
+// 4.   Frozen slots keep their control tags, so thawing rehashes them like
+//      any other table.
+// 5.   A frozen lookup compares the key of the slot the perfect hash
+//      names, since two names may share a fingerprint.
+
+// Match Byte
+// Returns a bit mask of the bytes of a group equal to the value.
+static unsigned int MatchByte(const signed char* group, signed char value) {
+#ifdef P4_RESOURCEMAP_SSE2
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return (unsigned int) _mm_movemask_epi8(
+            _mm_cmpeq_epi8(bytes, _mm_set1_epi8(value)));
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < resourcemap::GROUP; i++) {
+        if (group[i] == value) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+// Lowest Bit
+static int LowestBit(unsigned int mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#else
+    int bit = 0;
+    while ((mask & 1u) == 0) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Default Constructor
+resourcemap::resourcemap() {
+    control.assign(2 * GROUP, EMPTY);
+    slots.resize(GROUP);
+    used = 0;
+    deleted = 0;
+    frozen = false;
+}
+
+// Set a control byte and its mirror
+void resourcemap::SetControl(size_t index, signed char value) {
+    control[index] = value;
+    if (index < (size_t) GROUP) {
+        control[slots.size() + index] = value;
+    }
+}
+
+// Probe
+// Returns the slot holding the key and sets found, or returns the first
+// free slot on the probe sequence.
+size_t resourcemap::Probe(string_view key, size_t hash, bool& found) const {
+    size_t mask = slots.size() - 1;
+    signed char tag = (signed char) (hash & 0x7F);
+    size_t position = (hash >> 7) & mask;
+    size_t stride = 0;
+    size_t freeSlot = slots.size();
+
+    while (true) {
+        const signed char* group = control.data() + position;
+
+        for (unsigned int match = MatchByte(group, tag); match != 0;
+             match &= match - 1) {
+            size_t index = (position + LowestBit(match)) & mask;
+            if (slots[index].first == key) {
+                found = true;
+                return index;
+            }
+        }
+
+        if (freeSlot == slots.size()) {
+            unsigned int available = MatchByte(group, EMPTY) |
+                                     MatchByte(group, DELETED);
+            if (available != 0) {
+                freeSlot = (position + LowestBit(available)) & mask;
+            }
+        }
+        if (MatchByte(group, EMPTY) != 0) {
+            found = false;
+            return freeSlot;
+        }
+
+        stride += GROUP;
+        position = (position + stride) & mask;
+    }
+}
+
+// Find the quantity of a key
+double* resourcemap::Find(string_view key) {
+    if (frozen) {
+        long long index = frozenIndex.Lookup(key);
+        return index >= 0 && slots[index].first == key ?
+               &slots[index].second : nullptr;
+    }
+    bool found;
+    size_t index = Probe(key, hash<string_view>()(key), found);
+    return found ? &slots[index].second : nullptr;
+}
+
+// Find the quantity of a key
+const double* resourcemap::Find(string_view key) const {
+    if (frozen) {
+        long long index = frozenIndex.Lookup(key);
+        return index >= 0 && slots[index].first == key ?
+               &slots[index].second : nullptr;
+    }
+    bool found;
+    size_t index = Probe(key, hash<string_view>()(key), found);
+    return found ? &slots[index].second : nullptr;
+}
+
+// Find the quantity of a key, inserting 0 if it is missing
+double& resourcemap::FindOrInsert(string_view key) {
+    if (frozen) {
+        double* quantity = Find(key);
+        if (quantity == nullptr) {
+            throw out_of_range("Resource " + string(key) +
+                               " is not in the frozen catalog.");
+        }
+        return *quantity;
+    }
+
+    if ((used + deleted + 1) * 8 > slots.size() * 7) {
+        Rehash((used + 1) * 16 > slots.size() * 7 ? slots.size() * 2 :
+               slots.size());
+    }
+
+    size_t hashValue = hash<string_view>()(key);
+    bool found;
+    size_t index = Probe(key, hashValue, found);
+    if (!found) {
+        if (control[index] == DELETED) {
+            deleted--;
+        }
+        SetControl(index, (signed char) (hashValue & 0x7F));
+        slots[index].first.assign(key.data(), key.size());
+        slots[index].second = 0;
+        used++;
+    }
+    return slots[index].second;
+}
+
+// Remove a key and its quantity
+bool resourcemap::Erase(string_view key) {
+    if (frozen) {
+        throw logic_error("Cannot remove a resource from a frozen catalog.");
+    }
+    bool found;
+    size_t index = Probe(key, hash<string_view>()(key), found);
+    if (!found) {
+        return false;
+    }
+    SetControl(index, DELETED);
+    slots[index] = entry();
+    used--;
+    deleted++;
+    return true;
+}
+
+// Rehash
+// Moves every entry to its first free slot in a fresh table.
+void resourcemap::Rehash(size_t capacity) {
+    vector<signed char> oldControl(capacity + GROUP, EMPTY);
+    vector<entry> oldSlots(capacity);
+    oldControl.swap(control);
+    oldSlots.swap(slots);
+    deleted = 0;
+
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < oldSlots.size(); i++) {
+        if (oldControl[i] < 0) {
+            continue;
+        }
+        size_t hashValue = hash<string>()(oldSlots[i].first);
+        size_t position = (hashValue >> 7) & mask;
+        size_t stride = 0;
+        unsigned int empty;
+        while ((empty = MatchByte(control.data() + position, EMPTY)) == 0) {
+            stride += GROUP;
+            position = (position + stride) & mask;
+        }
+        size_t index = (position + LowestBit(empty)) & mask;
+        SetControl(index, oldControl[i]);
+        slots[index] = std::move(oldSlots[i]);
+    }
+}
+
+// Make room for a number of keys without rehashing
+void resourcemap::Reserve(size_t count) {
+    if (frozen) {
+        return;
+    }
+    size_t capacity = slots.size();
+    while ((count + 1) * 8 > capacity * 7) {
+        capacity *= 2;
+    }
+    if (capacity > slots.size()) {
+        Rehash(capacity);
+    }
+}
+
+// Remove every key
+void resourcemap::Clear() {
+    control.assign(2 * GROUP, EMPTY);
+    slots.assign(GROUP, entry());
+    used = 0;
+    deleted = 0;
+    frozenIndex = perfecthash();
+    frozen = false;
+}
+
+// Freeze
+// Builds the perfect hash over the keys and moves every entry to the index
+// the build reports for it, without hashing the keys a second time.
+void resourcemap::Freeze() {
+    if (frozen) {
+        return;
+    }
+
+    vector<string_view> keys;
+    keys.reserve(used);
+    for (auto& x : *this) {
+        keys.push_back(x.first);
+    }
+    vector<unsigned int> positions;
+    perfecthash index(keys, &positions);
+
+    vector<signed char> frozenControl(used + GROUP, 0);
+    vector<entry> frozenSlots(used);
+    for (size_t i = 0, k = 0; i < slots.size(); i++) {
+        if (control[i] >= 0) {
+            unsigned int position = positions[k++];
+            frozenControl[position] = control[i];
+            frozenSlots[position] = std::move(slots[i]);
+        }
+    }
+
+    control.swap(frozenControl);
+    slots.swap(frozenSlots);
+    frozenIndex = std::move(index);
+    deleted = 0;
+    frozen = true;
+}
+
+// Thaw
+void resourcemap::Thaw() {
+    if (!frozen) {
+        return;
+    }
+
+    size_t capacity = GROUP;
+    while ((used + 1) * 8 > capacity * 7) {
+        capacity *= 2;
+    }
+    frozen = false;
+    frozenIndex = perfecthash();
+    Rehash(capacity);
+}
+
+// Check if the key set is fixed
+bool resourcemap::QueryFrozen() const {
+    return frozen;
+}
+
+// Get the number of keys
+size_t resourcemap::QuerySize() const {
+    return used;
+}
+
+// Check if the map has no keys
+bool resourcemap::QueryEmpty() const {
+    return used == 0;
+}
+
+resourcemap::iterator resourcemap::begin() {
+    return iterator(this, 0);
+}
+
+resourcemap::iterator resourcemap::end() {
+    return iterator(this, slots.size());
+}
+
+resourcemap::const_iterator resourcemap::begin() const {
+    return const_iterator(this, 0);
+}
+
+resourcemap::const_iterator resourcemap::end() const {
+    return const_iterator(this, slots.size());
+}
+
+// Iterator
+resourcemap::iterator::iterator(resourcemap* map, size_t start) {
+    owner = map;
+    index = start;
+    Skip();
+}
+
+void resourcemap::iterator::Skip() {
+    while (index < owner->slots.size() && owner->control[index] < 0) {
+        index++;
+    }
+}
+
+resourcemap::entry& resourcemap::iterator::operator*() const {
+    return owner->slots[index];
+}
+
+resourcemap::entry* resourcemap::iterator::operator->() const {
+    return &owner->slots[index];
+}
+
+resourcemap::iterator& resourcemap::iterator::operator++() {
+    index++;
+    Skip();
+    return *this;
+}
+
+bool resourcemap::iterator::operator==(const iterator& other) const {
+    return owner == other.owner && index == other.index;
+}
+
+bool resourcemap::iterator::operator!=(const iterator& other) const {
+    return !operator==(other);
+}
+
+// Const Iterator
+resourcemap::const_iterator::const_iterator(const resourcemap* map,
+                                            size_t start) {
+    owner = map;
+    index = start;
+    Skip();
+}
+
+void resourcemap::const_iterator::Skip() {
+    while (index < owner->slots.size() && owner->control[index] < 0) {
+        index++;
+    }
+}
+
+const resourcemap::entry& resourcemap::const_iterator::operator*() const {
+    return owner->slots[index];
+}
+
+const resourcemap::entry* resourcemap::const_iterator::operator->() const {
+    return &owner->slots[index];
+}
+
+resourcemap::const_iterator& resourcemap::const_iterator::operator++() {
+    index++;
+    Skip();
+    return *this;
+}
+
+bool resourcemap::const_iterator::operator==(
+        const const_iterator& other) const {
+    return owner == other.owner && index == other.index;
+}
+
+bool resourcemap::const_iterator::operator!=(
+        const const_iterator& other) const {
+    return !operator==(other);
+}
@@ -0,0 +1,138 @@
+// AUTHOR:      Hongru He
+// FILENAME:    resourcemap.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_RESOURCEMAP_H
+#define P4_RESOURCEMAP_H
+#include "perfecthash.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The ResourceMap class is a flat, open-addressing hash map from resource
+// names to quantities. Lookups take a string_view, so no temporary string is
+// built, and every operation does a single probe sequence.
+// Class Invariants:
+// 1.   The capacity is a power of two, at least one group of control bytes,
+//      and at most 7/8 of the slots are full or deleted.
+// 2.   control[i] is EMPTY, DELETED or the low 7 bits of the hash of the key
+//      in slots[i]; the first GROUP control bytes are mirrored after the
+//      last one so a group can be loaded at any position.
+// 3.   Iteration visits the full slots in slot order.
+// 4.   While frozen, the table holds exactly one slot per key, at the index
+//      given by the perfect hash, and no key can be added or removed.
+
+class resourcemap {
+public:
+    typedef pair<string, double> entry;
+    static constexpr int GROUP = 16;
+
+private:
+    static constexpr signed char EMPTY = -128;
+    static constexpr signed char DELETED = -2;
+
+    vector<signed char> control;
+    vector<entry> slots;
+    size_t used;
+    size_t deleted;
+    perfecthash frozenIndex;
+    bool frozen;
+
+    size_t Probe(string_view, size_t, bool&) const;
+    // Find the slot of a key, or the slot to insert it into
+
+    void SetControl(size_t, signed char);
+    // Set a control byte and its mirror
+
+    void Rehash(size_t);
+    // Move every entry into a table with the given capacity
+
+public:
+    class iterator {
+    private:
+        resourcemap* owner;
+        size_t index;
+        void Skip();
+    public:
+        iterator(resourcemap*, size_t);
+        entry& operator*() const;
+        entry* operator->() const;
+        iterator& operator++();
+        bool operator==(const iterator&) const;
+        bool operator!=(const iterator&) const;
+    };
+
+    class const_iterator {
+    private:
+        const resourcemap* owner;
+        size_t index;
+        void Skip();
+    public:
+        const_iterator(const resourcemap*, size_t);
+        const entry& operator*() const;
+        const entry* operator->() const;
+        const_iterator& operator++();
+        bool operator==(const const_iterator&) const;
+        bool operator!=(const const_iterator&) const;
+    };
+
+    resourcemap();
+    // Default Constructor
+    // Explanation:     Initializes an empty map with one group of slots.
+    // Precondition:    None.
+    // Postcondition:   ResourceMap object is empty.
+
+    double* Find(string_view);
+    const double* Find(string_view) const;
+    // Find the quantity of a key
+    // Explanation:     Probes the groups whose control bytes match the hash.
+    // Precondition:    None.
+    // Postcondition:   Return a pointer to the quantity, or null if the key
+    //                  is not in the map. The pointer is valid until the
+    //                  next insertion.
+
+    double& FindOrInsert(string_view);
+    // Find the quantity of a key, inserting 0 if it is missing
+    // Explanation:     Grows the table first if needed, then probes once.
+    // Precondition:    None.
+    // Postcondition:   Return a reference to the quantity, valid until the
+    //                  next insertion. Throws out_of_range if the map is
+    //                  frozen and the key is missing.
+
+    bool Erase(string_view);
+    // Remove a key and its quantity
+
+    void Freeze();
+    // Move the keys into minimal perfect hash order and fix the key set
+
+    void Thaw();
+    // Move the keys back into a regular table that accepts new keys
+
+    bool QueryFrozen() const;
+    // Check if the key set is fixed
+
+    void Reserve(size_t);
+    // Make room for a number of keys without rehashing
+
+    void Clear();
+    // Remove every key
+
+    size_t QuerySize() const;
+    // Get the number of keys
+
+    bool QueryEmpty() const;
+    // Check if the map has no keys
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+};
+
+
+#endif //P4_RESOURCEMAP_H
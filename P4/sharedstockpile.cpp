@@ -0,0 +1,308 @@
+// AUTHOR:      Hongru He
+// FILENAME:    sharedstockpile.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "sharedstockpile.h"
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   The segment is a header followed by a power-of-two table of
+//      cache-line sized slots, found by linear probing from the hash of the
+//      name, so readers need no index of their own.
+// 2.   The table has twice the requested capacity, which keeps probe
+//      sequences short and guarantees an empty slot ends every probe.
+// 3.   Quantities are lock-free atomics, so a single read never sees a torn
+//      value; the segment sequence only serves readers that want a
+//      consistent view of several resources.
+// 4.   The writer only creates a new segment and never opens an existing
+//      one, so it cannot overwrite or later unlink a segment it does not
+//      own. mappingSize is the real size of the mapping for both sides.
+
+static_assert(atomic<double>::is_always_lock_free &&
+              atomic<unsigned long long>::is_always_lock_free,
+              "Shared memory needs lock-free atomics.");
+
+static const unsigned long long SEGMENT_TAG = 0x3150534b434f5453ull;
+
+// Hash Name
+static unsigned int HashName(const string& name) {
+    unsigned int hash = 2166136261u;
+    for (char c : name) {
+        hash ^= (unsigned char) c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Overloaded Constructor
+// Creates the segment for the writer.
+sharedstockpile::sharedstockpile(const string& name, int capacity) {
+    if (capacity <= 0) {
+        throw invalid_argument("Capacity must be positive.");
+    }
+
+    unsigned int tableSize = 1;
+    while (tableSize < (unsigned int) capacity * 2) {
+        tableSize *= 2;
+    }
+
+    segmentName = name;
+    writer = true;
+    Map(true, sizeof(segmentheader) + tableSize * sizeof(segmentslot));
+
+    header->tag = SEGMENT_TAG;
+    header->capacity = tableSize;
+    header->sequence.store(0);
+    header->count.store(0);
+    for (unsigned int i = 0; i < tableSize; i++) {
+        slots[i].ready.store(0);
+    }
+}
+
+// Overloaded Constructor
+// Opens the segment for a reader.
+sharedstockpile::sharedstockpile(const string& name) {
+    segmentName = name;
+    writer = false;
+    Map(false, 0);
+    // The slot table must be a power of two that fits in the mapping
+    unsigned int capacity = header->capacity;
+    if (header->tag != SEGMENT_TAG || capacity == 0 ||
+        (capacity & (capacity - 1)) != 0 ||
+        capacity > (mappingSize - sizeof(segmentheader)) /
+                   sizeof(segmentslot)) {
+        Unmap();
+        throw runtime_error(name + " is not a shared stockpile.");
+    }
+}
+
+// Destructor
+sharedstockpile::~sharedstockpile() {
+    Unmap();
+}
+
+#ifdef _WIN32
+// Map
+void sharedstockpile::Map(bool create, size_t size) {
+    string mappingName = "Local\\" + segmentName;
+    if (create) {
+        handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr,
+                                    PAGE_READWRITE, (DWORD) (size >> 32),
+                                    (DWORD) size, mappingName.c_str());
+    }
+    else {
+        handle = OpenFileMappingA(FILE_MAP_READ, FALSE, mappingName.c_str());
+    }
+    if (handle == nullptr) {
+        throw runtime_error("Cannot open shared memory " + segmentName + ".");
+    }
+    if (create && GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(handle);
+        throw runtime_error("Shared memory " + segmentName +
+                            " already exists.");
+    }
+
+    mapping = MapViewOfFile(handle, create ? FILE_MAP_ALL_ACCESS :
+                                    FILE_MAP_READ, 0, 0, size);
+    if (mapping == nullptr) {
+        CloseHandle(handle);
+        throw runtime_error("Cannot map shared memory " + segmentName + ".");
+    }
+    if (!create) {
+        // A view of the whole mapping spans whole pages, so its region size
+        // is the real size rather than the 0 passed in
+        MEMORY_BASIC_INFORMATION region;
+        size = VirtualQuery(mapping, &region, sizeof(region)) == 0 ? 0 :
+               region.RegionSize;
+        if (size < sizeof(segmentheader)) {
+            UnmapViewOfFile(mapping);
+            CloseHandle(handle);
+            throw runtime_error(segmentName + " is not a shared stockpile.");
+        }
+    }
+    mappingSize = size;
+    header = static_cast<segmentheader*>(mapping);
+    slots = reinterpret_cast<segmentslot*>(header + 1);
+}
+
+// Unmap
+void sharedstockpile::Unmap() {
+    UnmapViewOfFile(mapping);
+    CloseHandle(handle);
+}
+#else
+// Map
+void sharedstockpile::Map(bool create, size_t size) {
+    string posixName = segmentName[0] == '/' ? segmentName :
+                       "/" + segmentName;
+    int descriptor = create ?
+                     shm_open(posixName.c_str(), O_CREAT | O_EXCL | O_RDWR,
+                              0644) :
+                     shm_open(posixName.c_str(), O_RDONLY, 0);
+    if (descriptor < 0 && create && errno == EEXIST) {
+        throw runtime_error("Shared memory " + segmentName +
+                            " already exists.");
+    }
+    if (descriptor < 0) {
+        throw runtime_error("Cannot open shared memory " + segmentName + ".");
+    }
+
+    if (create) {
+        if (ftruncate(descriptor, size) != 0) {
+            close(descriptor);
+            throw runtime_error("Cannot size shared memory " + segmentName +
+                                ".");
+        }
+    }
+    else {
+        off_t end = lseek(descriptor, 0, SEEK_END);
+        size = end < 0 ? 0 : (size_t) end;
+        if (size < sizeof(segmentheader)) {
+            close(descriptor);
+            throw runtime_error(segmentName + " is not a shared stockpile.");
+        }
+    }
+
+    mapping = mmap(nullptr, size, create ? PROT_READ | PROT_WRITE : PROT_READ,
+                   MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        throw runtime_error("Cannot map shared memory " + segmentName + ".");
+    }
+    mappingSize = size;
+    header = static_cast<segmentheader*>(mapping);
+    slots = reinterpret_cast<segmentslot*>(header + 1);
+}
+
+// Unmap
+void sharedstockpile::Unmap() {
+    munmap(mapping, mappingSize);
+    if (writer) {
+        string posixName = segmentName[0] == '/' ? segmentName :
+                           "/" + segmentName;
+        shm_unlink(posixName.c_str());
+    }
+}
+#endif
+
+// Find Slot
+// Probes from the hash of the name until the name or an empty slot is found.
+const sharedstockpile::segmentslot* sharedstockpile::FindSlot(
+        const string& name) const {
+    unsigned int mask = header->capacity - 1;
+    for (unsigned int i = HashName(name) & mask; ; i = (i + 1) & mask) {
+        const segmentslot& slot = slots[i];
+        if (slot.ready.load(memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        if (strncmp(slot.name, name.c_str(), NAMESIZE) == 0) {
+            return &slot;
+        }
+    }
+}
+
+// Publish the quantity of a resource
+void sharedstockpile::Publish(const string& name, double quantity) {
+    CheckPublish(name);
+
+    header->sequence.fetch_add(1, memory_order_acq_rel);
+
+    segmentslot* slot = const_cast<segmentslot*>(FindSlot(name));
+    if (slot == nullptr) {
+        unsigned int mask = header->capacity - 1;
+        unsigned int i = HashName(name) & mask;
+        while (slots[i].ready.load(memory_order_relaxed) != 0) {
+            i = (i + 1) & mask;
+        }
+        slot = &slots[i];
+        memset(slot->name, 0, NAMESIZE);
+        memcpy(slot->name, name.data(), name.size());
+        slot->quantity.store(quantity, memory_order_relaxed);
+        slot->ready.store(1, memory_order_release);
+        header->count.fetch_add(1, memory_order_relaxed);
+    }
+    else {
+        slot->quantity.store(quantity, memory_order_release);
+    }
+
+    header->sequence.fetch_add(1, memory_order_release);
+}
+
+// Check that a resource can be published
+void sharedstockpile::CheckPublish(const string& name) const {
+    if (!writer) {
+        throw logic_error("Only the writer can publish quantities.");
+    }
+    if (name.size() >= (size_t) NAMESIZE) {
+        throw invalid_argument("Resource name " + name + " is too long.");
+    }
+    if (header->count.load() * 2 >= header->capacity &&
+        FindSlot(name) == nullptr) {
+        throw runtime_error("Shared memory " + segmentName + " is full.");
+    }
+}
+
+// Get the quantity of a resource
+double sharedstockpile::QueryQuantity(const string& name) const {
+    const segmentslot* slot = FindSlot(name);
+    if (slot == nullptr) {
+        return -1;
+    }
+    return slot->quantity.load(memory_order_acquire);
+}
+
+// Get all the published resources with their quantities
+string sharedstockpile::QueryResources() const {
+    vector<pair<string, double>> copied;
+
+    while (true) {
+        unsigned long long before = header->sequence.load(
+                memory_order_acquire);
+        if (before % 2 == 1) {
+            continue;
+        }
+
+        copied.clear();
+        for (unsigned int i = 0; i < header->capacity; i++) {
+            if (slots[i].ready.load(memory_order_acquire) != 0) {
+                copied.emplace_back(string(slots[i].name),
+                                    slots[i].quantity.load(
+                                            memory_order_relaxed));
+            }
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        if (header->sequence.load(memory_order_relaxed) == before) {
+            break;
+        }
+    }
+
+    if (copied.empty()) {
+        return "This stockpile is empty.";
+    }
+
+    stringstream result;
+    for (auto& x : copied) {
+        result << x.second << " " << x.first << "\n";
+    }
+    return result.str();
+}
+
+// Get the number of published resources
+int sharedstockpile::QueryCount() const {
+    return header->count.load(memory_order_acquire);
+}
@@ -0,0 +1,124 @@
+// AUTHOR:      Hongru He
+// FILENAME:    sharedstockpile.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_SHAREDSTOCKPILE_H
+#define P4_SHAREDSTOCKPILE_H
+#include <atomic>
+#include <string>
+
+using namespace std;
+
+// The SharedStockpile class lays out resource quantities in a named shared
+// memory segment, so other local processes can read them without asking the
+// crafting process.
+// Class Invariants:
+// 1.   Only the process that created the segment writes to it; any number
+//      of processes may open it for reading.
+// 2.   A slot's name never changes once the slot is marked ready, so readers
+//      can compare names without a lock.
+// 3.   The segment sequence is odd while the writer is changing quantities,
+//      and even otherwise.
+
+class sharedstockpile {
+public:
+    static constexpr int NAMESIZE = 48;
+
+private:
+    struct alignas(64) segmentheader {
+        unsigned long long tag;
+        unsigned int capacity;
+        unsigned int reserved;
+        atomic<unsigned long long> sequence;
+        atomic<unsigned int> count;
+    };
+
+    struct alignas(64) segmentslot {
+        atomic<unsigned int> ready;
+        unsigned int reserved;
+        char name[NAMESIZE];
+        atomic<double> quantity;
+    };
+
+    string segmentName;
+    void* mapping;
+    size_t mappingSize;
+    bool writer;
+    segmentheader* header;
+    segmentslot* slots;
+#ifdef _WIN32
+    void* handle;
+#endif
+
+    void Map(bool, size_t);
+    // Create or open the segment and map it into memory
+
+    void Unmap();
+    // Release the mapping and, for the writer, the segment
+
+    const segmentslot* FindSlot(const string&) const;
+    // Find the slot of a resource, or return null
+
+public:
+    sharedstockpile(const string&, int);
+    // Overloaded Constructor
+    // Explanation:     Creates a segment with room for the given number of
+    //                  resources and opens it for writing.
+    // Precondition:    No segment with this name exists; otherwise a
+    //                  runtime_error is thrown and that segment is left as
+    //                  it is.
+    // Postcondition:   SharedStockpile object is an empty writer.
+
+    explicit sharedstockpile(const string&);
+    // Overloaded Constructor
+    // Explanation:     Opens an existing segment for reading.
+    // Precondition:    A writer created the segment.
+    // Postcondition:   SharedStockpile object is a reader.
+
+    ~sharedstockpile();
+    // Destructor
+    // Explanation:     Unmaps the segment; the writer also removes its name
+    //                  so no new reader can open it.
+    // Precondition:    None.
+    // Postcondition:   The mapping is released.
+
+    sharedstockpile(const sharedstockpile&) = delete;
+    sharedstockpile& operator=(const sharedstockpile&) = delete;
+
+    void CheckPublish(const string&) const;
+    // Check that a resource can be published
+    // Explanation:     Throws what Publish would throw, without changing the
+    //                  segment, so a Stockpile can check before it mutates.
+    // Precondition:    None.
+    // Postcondition:   A logic_error, invalid_argument or runtime_error is
+    //                  thrown if Publish would fail.
+
+    void Publish(const string&, double);
+    // Publish the quantity of a resource
+    // Explanation:     Stores the quantity in the resource's slot, creating
+    //                  the slot if necessary.
+    // Precondition:    This is the writer, the name is shorter than NAMESIZE
+    //                  and the segment is not full.
+    // Postcondition:   Readers see the new quantity.
+
+    double QueryQuantity(const string&) const;
+    // Get the quantity of a resource
+    // Explanation:     Reads the quantity straight from the segment.
+    // Precondition:    None.
+    // Postcondition:   Return the quantity, or -1 if the resource is not
+    //                  published.
+
+    string QueryResources() const;
+    // Get all the published resources with their quantities
+    // Explanation:     Copies every slot and retries until no write happened
+    //                  in between, so the result is a consistent snapshot.
+    // Precondition:    None.
+    // Postcondition:   Return a string of quantities and resource names.
+
+    int QueryCount() const;
+    // Get the number of published resources
+};
+
+
+#endif //P4_SHAREDSTOCKPILE_H
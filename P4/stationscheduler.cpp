@@ -0,0 +1,227 @@
+// AUTHOR:      Hongru He
+// FILENAME:    stationscheduler.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "stationscheduler.h"
+#include "plandag.h"
+#include <algorithm>
+#include <chrono>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Durations are looked up once per Schedule into a steps by stations
+//      table; a step's bottom level uses its shortest duration, and a
+//      join of the PlanDAG takes no time and no station.
+// 2.   ListSchedule takes ready steps from a heap by priority, ties going
+//      to the lower index, so a schedule depends only on the priorities.
+// 3.   Steps are ordered by start and then by index. A step with a zero
+//      duration can start when its predecessor does, and has the higher
+//      index, so the order always respects the dependencies.
+
+// Overloaded Constructor
+stationscheduler::stationscheduler(const plan& steps, int stations) {
+    if (stations < 1) {
+        throw invalid_argument("There must be at least one station.");
+    }
+    source = &steps;
+    stationCount = stations;
+    durations.resize(stations);
+}
+
+// Set Duration
+void stationscheduler::SetDuration(int station, const formula& recipe,
+                                   double duration) {
+    if (station < 0 || station >= stationCount) {
+        throw invalid_argument("There is no such station.");
+    }
+    if (duration < 0) {
+        throw invalid_argument("A duration cannot be negative.");
+    }
+    durations[station][recipe.QueryRecipeHash()] = duration;
+}
+
+// Set Default Duration
+void stationscheduler::SetDefaultDuration(double duration) {
+    if (duration < 0) {
+        throw invalid_argument("A duration cannot be negative.");
+    }
+    defaultDuration = duration;
+}
+
+// List Schedule
+double stationscheduler::ListSchedule(const plandag& dag,
+                                      const vector<double>& table,
+                                      const vector<double>& priority,
+                                      vector<scheduledstep>& result) const {
+    int n = dag.QuerySize();
+    result.assign(n, scheduledstep());
+    vector<int> waiting(dag.QueryNodeCount());
+    vector<double> readyTime(dag.QueryNodeCount(), 0);
+    priority_queue<pair<double, int>> ready;
+    for (int s = 0; s < dag.QueryNodeCount(); s++) {
+        waiting[s] = (int) dag.QueryPredecessors(s).size();
+        if (waiting[s] == 0 && s < n) {
+            ready.push({priority[s], -s});
+        }
+    }
+    // Passes a finish time on to the successors; a join passes it through
+    auto release = [&](int node, double finish) {
+        for (int next : dag.QuerySuccessors(node)) {
+            readyTime[next] = max(readyTime[next], finish);
+            if (--waiting[next] > 0) {
+                continue;
+            }
+            if (next < n) {
+                ready.push({priority[next], -next});
+                continue;
+            }
+            for (int step : dag.QuerySuccessors(next)) {
+                readyTime[step] = max(readyTime[step], readyTime[next]);
+                if (--waiting[step] == 0) {
+                    ready.push({priority[step], -step});
+                }
+            }
+        }
+    };
+
+    vector<double> stationFree(stationCount, 0);
+    double length = 0;
+    while (!ready.empty()) {
+        int s = -ready.top().second;
+        ready.pop();
+
+        int best = 0;
+        double bestFinish = 0;
+        for (int k = 0; k < stationCount; k++) {
+            double finish = max(readyTime[s], stationFree[k]) +
+                            table[(size_t) s * stationCount + k];
+            if (k == 0 || finish < bestFinish) {
+                best = k;
+                bestFinish = finish;
+            }
+        }
+        double duration = table[(size_t) s * stationCount + best];
+        result[s] = {best, bestFinish - duration, bestFinish};
+        stationFree[best] = bestFinish;
+        length = max(length, bestFinish);
+
+        release(s, bestFinish);
+    }
+    return length;
+}
+
+// Schedule
+// Perturbs the best priorities so far, which keeps the search near good
+// schedules while still letting it escape ties
+double stationscheduler::Schedule(const scheduleoptions& options) {
+    plandag dag(*source);
+    int n = dag.QuerySize();
+
+    vector<double> table((size_t) n * stationCount);
+    vector<double> shortest(n);
+    for (int s = 0; s < n; s++) {
+        unsigned long long recipe = source->QueryFormula(s).QueryRecipeHash();
+        for (int k = 0; k < stationCount; k++) {
+            auto item = durations[k].find(recipe);
+            double duration = item == durations[k].end() ? defaultDuration :
+                              item->second;
+            table[(size_t) s * stationCount + k] = duration;
+            shortest[s] = k == 0 ? duration : min(shortest[s], duration);
+        }
+    }
+
+    const vector<int>& order = dag.QueryOrder();
+    vector<double> bottomLevel(dag.QueryNodeCount(), 0);
+    for (auto s = order.rbegin(); s != order.rend(); ++s) {
+        double below = 0;
+        for (int next : dag.QuerySuccessors(*s)) {
+            below = max(below, bottomLevel[next]);
+        }
+        bottomLevel[*s] = (*s < n ? shortest[*s] : 0) + below;
+    }
+
+    makespan = ListSchedule(dag, table, bottomLevel, schedule);
+
+    mt19937 gen(options.seed);
+    uniform_real_distribution<double> noise(-0.5, 0.5);
+    uniform_real_distribution<double> pick(0, 1);
+    vector<double> bestPriority = bottomLevel;
+    vector<double> candidate;
+    vector<scheduledstep> trial;
+    auto deadline = chrono::steady_clock::now() +
+                    chrono::milliseconds(options.timeLimitMillis);
+    for (int it = 0; it < options.iterations && n > 1; it++) {
+        if (options.timeLimitMillis > 0 &&
+            chrono::steady_clock::now() > deadline) {
+            break;
+        }
+        candidate = bestPriority;
+        double rate = min(1.0, 4.0 / n);
+        for (int s = 0; s < n; s++) {
+            if (pick(gen) < rate) {
+                candidate[s] += noise(gen) * (shortest[s] + 1);
+            }
+        }
+        double length = ListSchedule(dag, table, candidate, trial);
+        if (length <= makespan) {
+            makespan = length;
+            bestPriority.swap(candidate);
+            schedule.swap(trial);
+        }
+    }
+    return makespan;
+}
+
+// Query Makespan
+double stationscheduler::QueryMakespan() const {
+    return makespan;
+}
+
+// Query Step
+const scheduledstep& stationscheduler::QueryStep(int step) const {
+    if (step < 0 || step >= (int) schedule.size()) {
+        throw out_of_range("Index out of range.");
+    }
+    return schedule[step];
+}
+
+// Query Station Steps
+vector<int> stationscheduler::QueryStationSteps(int station) const {
+    vector<int> steps;
+    for (int s : QueryOrder()) {
+        if (schedule[s].station == station) {
+            steps.push_back(s);
+        }
+    }
+    return steps;
+}
+
+// Query Order
+vector<int> stationscheduler::QueryOrder() const {
+    vector<int> order(schedule.size());
+    for (size_t s = 0; s < order.size(); s++) {
+        order[s] = (int) s;
+    }
+    sort(order.begin(), order.end(), [this](int a, int b) {
+        if (schedule[a].start != schedule[b].start) {
+            return schedule[a].start < schedule[b].start;
+        }
+        return a < b;
+    });
+    return order;
+}
+
+// To Executable Plan
+executableplan stationscheduler::ToExecutablePlan() const {
+    executableplan result;
+    for (int s : QueryOrder()) {
+        result.Add(formula(source->QueryFormula(s)));
+    }
+    return result;
+}
@@ -0,0 +1,104 @@
+// AUTHOR:      Hongru He
+// FILENAME:    stationscheduler.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_STATIONSCHEDULER_H
+#define P4_STATIONSCHEDULER_H
+#include "executableplan.h"
+#include "plan.h"
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class plandag;
+
+// How long a StationScheduler improves its first schedule.
+struct scheduleoptions {
+    int iterations = 200;
+    int timeLimitMillis = 0;    // 0 means no limit
+    unsigned int seed = 1;
+};
+
+// When and where one step of a Plan runs.
+struct scheduledstep {
+    int station = -1;
+    double start = 0;
+    double finish = 0;
+};
+
+// The StationScheduler class assigns the steps of a Plan to a fixed number
+// of crafting stations and gives each a start time. A station runs one step
+// at a time, and how long a step takes depends on its recipe and station.
+// Class Invariants:
+// 1.   A step starts after every step it depends on in the PlanDAG has
+//      finished, and the steps of a station never overlap.
+// 2.   The first schedule comes from list scheduling by bottom level: the
+//      ready step with the longest remaining chain goes to the station
+//      where it finishes first. The improvement search perturbs those
+//      priorities and keeps any schedule that is no longer.
+// 3.   Without a time limit, the same options give the same schedule. A
+//      time limit can stop the search after a number of iterations that
+//      depends on the machine, so the result may differ between runs.
+
+class stationscheduler {
+private:
+    const plan* source;
+    int stationCount;
+    double defaultDuration = 1;
+    vector<unordered_map<unsigned long long, double>> durations;
+    vector<scheduledstep> schedule;
+    double makespan = 0;
+
+    double ListSchedule(const plandag&, const vector<double>&,
+                        const vector<double>&, vector<scheduledstep>&) const;
+    // Build a schedule from step priorities and return its makespan
+
+public:
+    stationscheduler(const plan&, int);
+    // Overloaded Constructor
+    // Explanation:     Initializes a StationScheduler for a Plan and a
+    //                  number of stations; every step takes 1 unit of time
+    //                  until durations are set.
+    // Precondition:    The Plan outlives the scheduler and there is at
+    //                  least one station; otherwise an invalid_argument
+    //                  exception is thrown.
+    // Postcondition:   StationScheduler object is ready to schedule.
+
+    void SetDuration(int, const formula&, double);
+    // Set how long a station takes for a recipe
+    // Precondition:    The station exists and the duration is not
+    //                  negative; otherwise an invalid_argument exception is
+    //                  thrown.
+    // Postcondition:   Steps with an equal recipe take that long there.
+
+    void SetDefaultDuration(double);
+    // Set how long a step takes when no duration was set for it
+
+    double Schedule(const scheduleoptions& = scheduleoptions());
+    // Schedule the steps of the Plan
+    // Explanation:     Runs list scheduling, then the improvement search
+    //                  until the iterations or the time limit, if one is
+    //                  set, run out.
+    // Precondition:    None.
+    // Postcondition:   Return the makespan of the best schedule.
+
+    double QueryMakespan() const;
+    // Get the makespan of the last schedule
+
+    const scheduledstep& QueryStep(int) const;
+    // Get the station and times of a step in the last schedule
+
+    vector<int> QueryStationSteps(int) const;
+    // Get the steps of a station in the order it runs them
+
+    vector<int> QueryOrder() const;
+    // Get the steps in the order they start
+
+    executableplan ToExecutablePlan() const;
+    // Build an ExecutablePlan that runs the steps in the order they start
+};
+
+
+#endif //P4_STATIONSCHEDULER_H
@@ -4,21 +4,50 @@
 // VERSION:     V1.0
 
 #include "stockpile.h"
+#include "journal.h"
+#include "writeaheadlog.h"
+#include "sharedstockpile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <string>
 #include <sstream>
+#include <stdexcept>
+#include <utility>
 
 using namespace std;
 
 // Implementation Invariants:
-// 1.   This class uses a hash map to store resource names as keys and their
-//      quantities as values, facilitating efficient querying and updating of
-//      resources.
+// 1.   This class uses a flat hash map to store resource names as keys and
+//      their quantities as values, facilitating efficient querying and
+//      updating of resources. Every operation on a single resource does one
+//      probe of the map.
 // 2.   It provides functions to query the quantity of resources, add or
 //      remove resources, and check for the availability of specific quantities
 //      of resources.
 // 3.   Operations that modify the stockpile (e.g., adding or removing
 //      resources) ensure the integrity of the stockpile by not allowing
 //      invalid states, such as negative quantities.
+// 4.   An attached Journal, WriteAheadLog or SharedStockpile belongs to this
+//      Stockpile only; it is moved along with the resources but never shared
+//      by copies. Assignment would replace the resources without a record,
+//      so it is refused while one is attached.
+// 5.   A mutation is checked against the SharedStockpile, then appended to
+//      the WriteAheadLog, then applied, so the mirror cannot fail after the
+//      map and the log have changed.
+// 6.   Bulk operations probe the hash map once per entry of the other
+//      side. While a log or mirror is attached they go through
+//      IncreaseResource entry by entry, so every change is still recorded as
+//      a delta that replays to the same bits.
+// 7.   Watchers are kept per resource, so a mutation of a resource nobody
+//      watches costs one emptiness check, or one failed lookup while other
+//      resources are watched. Watchers are not copied with the resources,
+//      and a notification walks them without copying them either.
+// 8.   A frozen Stockpile keeps its resources in minimal perfect hash order
+//      and rejects new resources before anything is logged.
+// 9.   Reports select pointers to the entries and only sort what they
+//      print, so a page of a sorted report costs O(n log page size) and no
+//      copy of the names.
 
 // Default Constructor
 stockpile::stockpile() = default;
@@ -26,36 +55,64 @@ stockpile::stockpile() = default;
 // Overloaded Constructor
 stockpile::stockpile(string* material, double* number, int size) {
     for (int i = 0; i < size; i++) {
-        resources[material[i]] = number[i];
+        resources.FindOrInsert(material[i]) = number[i];
     }
 }
 
 // Destructor
 stockpile::~stockpile() {
-    resources.clear();
+    resources.Clear();
 }
 
 // Copy Constructor
 stockpile::stockpile(const stockpile& other) {
     for (auto& x : other.resources) {
-        resources[x.first] = x.second;
+        resources.FindOrInsert(x.first) = x.second;
     }
 }
 
 // Move Constructor
 stockpile::stockpile(stockpile&& other) noexcept {
     for (auto& x : other.resources) {
-        resources[x.first] = x.second;
+        resources.FindOrInsert(x.first) = x.second;
     }
-    other.resources.clear();
+    other.resources.Clear();
+    eventLog = std::move(other.eventLog);
+    durableLog = std::move(other.durableLog);
+    lastSequence = other.lastSequence;
+    sharedView = std::move(other.sharedView);
+    watchers = std::move(other.watchers);
+    nextWatcherId = other.nextWatcherId;
 }
 
 // Overloaded Assignment Operator
+// The watchers are told about every resource whose quantity changed, and a
+// resource that is gone counts as 0.
 stockpile& stockpile::operator=(const stockpile& other) {
     if (this != &other) {
-        resources.clear();
+        CheckAssignable();
+        vector<pair<string, pair<double, double>>> changes;
+        if (!watchers.empty()) {
+            for (auto& x : resources) {
+                const double* next = other.resources.Find(x.first);
+                double quantity = next != nullptr ? *next : 0;
+                if (quantity != x.second) {
+                    changes.push_back({x.first, {x.second, quantity}});
+                }
+            }
+            for (auto& x : other.resources) {
+                if (resources.Find(x.first) == nullptr && x.second != 0) {
+                    changes.push_back({x.first, {0, x.second}});
+                }
+            }
+        }
+
+        resources.Clear();
         for (auto &x: other.resources) {
-            resources[x.first] = x.second;
+            resources.FindOrInsert(x.first) = x.second;
+        }
+        for (auto& x : changes) {
+            Notify(x.first, x.second.first, x.second.second);
         }
     }
 
@@ -63,15 +120,23 @@ stockpile& stockpile::operator=(const stockpile& other) {
 }
 
 // Move Assignment Operator
-stockpile& stockpile::operator=(stockpile&& other) noexcept {
+stockpile& stockpile::operator=(stockpile&& other) {
     if (this != &other) {
-        resources.clear();
+        CheckAssignable();
+        resources.Clear();
 
         for (auto &x: other.resources) {
-            resources[x.first] = x.second;
+            resources.FindOrInsert(x.first) = x.second;
         }
 
-        other.resources.clear();
+        other.resources.Clear();
+        eventLog = std::move(other.eventLog);
+        durableLog = std::move(other.durableLog);
+        lastSequence = other.lastSequence;
+        sharedView = std::move(other.sharedView);
+        watchers = std::move(other.watchers);
+        nextWatcherId = other.nextWatcherId;
+        watcherGeneration++;
     }
 
     return *this;
@@ -79,13 +144,13 @@ stockpile& stockpile::operator=(stockpile&& other) noexcept {
 
 // Get all the resources and their quantities
 string stockpile::QueryResources() {
-    if (resources.empty()) {
+    if (resources.QueryEmpty()) {
         return "This stockpile is empty.";
     }
 
     stringstream result;
 
-    for (auto x : resources) {
+    for (const auto& x : resources) {
         result << x.second << " " << x.first << "\n";
     }
 
@@ -93,34 +158,423 @@ string stockpile::QueryResources() {
 }
 
 // Get the quantity of a specific resource
-int stockpile::QueryQuantity(const string& resourceName) const {
-    auto item = resources.find(resourceName);
-    if (item != resources.end()) {
-        return item->second;
+int stockpile::QueryQuantity(string_view resourceName) const {
+    const double* quantity = resources.Find(resourceName);
+    if (quantity != nullptr) {
+        return *quantity;
     }
     return -1;
 }
 
 // Increase the quantity of the specific resource
 void stockpile::IncreaseResource(const string& resourceName, double numAdd) {
-    resources[resourceName] += numAdd;
+    if (sharedView) {
+        sharedView->CheckPublish(resourceName);
+    }
+    double& quantity = resources.FindOrInsert(resourceName);
+    if (durableLog) {
+        lastSequence = durableLog->Append(eventtype::Increase, resourceName,
+                                          numAdd);
+    }
+    double oldQuantity = quantity;
+    quantity += numAdd;
+    if (sharedView) {
+        sharedView->Publish(resourceName, quantity);
+    }
+    if (eventLog) {
+        eventLog->RecordIncrease(resourceName, numAdd, *this);
+    }
+    if (!watchers.empty()) {
+        Notify(resourceName, oldQuantity, oldQuantity + numAdd);
+    }
 }
 
 // Decrease the quantity of the specific resource
 bool stockpile::DecreaseResource(const string& resourceName, int numDec) {
-    auto item = resources.find(resourceName);
-    if (item != resources.end() && resources[resourceName] >= numDec) {
-        resources[resourceName] -= numDec;
+    double* quantity = resources.Find(resourceName);
+    if (quantity != nullptr && *quantity >= numDec) {
+        if (sharedView) {
+            sharedView->CheckPublish(resourceName);
+        }
+        if (durableLog) {
+            lastSequence = durableLog->Append(eventtype::Decrease,
+                                              resourceName, numDec);
+        }
+        double oldQuantity = *quantity;
+        *quantity -= numDec;
+        if (sharedView) {
+            sharedView->Publish(resourceName, *quantity);
+        }
+        if (eventLog) {
+            eventLog->RecordDecrease(resourceName, numDec, *this);
+        }
+        if (!watchers.empty()) {
+            Notify(resourceName, oldQuantity, oldQuantity - numDec);
+        }
         return true;
     }
     return false;
 }
 
 // Check if the stockpile has sufficient quantity of parameter resource
-bool stockpile::CheckMaterial(string& material, int number) {
-    if (resources.find(material) != resources.end()
-        && resources[material] >= number) {
+bool stockpile::CheckMaterial(string_view material, int number) const {
+    const double* quantity = resources.Find(material);
+    if (quantity != nullptr && *quantity >= number) {
         return true;
     }
     return false;
-}
\ No newline at end of file
+}
+
+// Record every mutation in a Journal
+void stockpile::AttachJournal(shared_ptr<journal> log) {
+    eventLog = std::move(log);
+    if (eventLog) {
+        eventLog->Snapshot(*this);
+    }
+}
+
+// Make every mutation durable through a WriteAheadLog
+void stockpile::AttachWriteAheadLog(shared_ptr<writeaheadlog> log) {
+    durableLog = std::move(log);
+    if (durableLog && durableLog->QueryEmptyAtOpen() &&
+        durableLog->QueryLastSequence() == 0) {
+        for (auto& x : resources) {
+            lastSequence = durableLog->Append(eventtype::Increase, x.first,
+                                              x.second);
+        }
+    }
+}
+
+// Get the WriteAheadLog sequence number of the last mutation
+unsigned long long stockpile::QueryLastSequence() const {
+    return lastSequence;
+}
+
+// Mirror every quantity into a shared memory segment
+void stockpile::AttachSharedMemory(shared_ptr<sharedstockpile> view) {
+    sharedView = std::move(view);
+    if (sharedView) {
+        try {
+            for (auto& x : resources) {
+                sharedView->Publish(x.first, x.second);
+            }
+        }
+        catch (...) {
+            sharedView.reset();
+            throw;
+        }
+    }
+}
+
+// Check that assigning to this Stockpile cannot bypass a log or mirror
+void stockpile::CheckAssignable() const {
+    if (eventLog || durableLog || sharedView) {
+        throw logic_error("Cannot assign to a stockpile with a journal, log "
+                          "or mirror attached.");
+    }
+}
+
+// Check if any log or mirror has to see every single mutation
+bool stockpile::QueryObserved() const {
+    return eventLog || durableLog || sharedView || !watchers.empty();
+}
+
+// Call the watchers of a resource whose quantity has changed
+// The list is walked in place. Watchers are kept in id order, so when a
+// callback adds or removes watchers the walk finds the list again and
+// resumes after the last id it called; watchers added during the walk are
+// skipped, and removed ones are not called.
+void stockpile::Notify(const string& resourceName, double oldQuantity,
+                       double newQuantity) {
+    auto item = watchers.find(resourceName);
+    if (item == watchers.end()) {
+        return;
+    }
+
+    int limit = nextWatcherId;
+    unsigned long generation = watcherGeneration;
+    const vector<watcher>* list = &item->second;
+    size_t i = 0;
+    while (i < list->size() && (*list)[i].id < limit) {
+        const watcher& x = (*list)[i];
+        i++;
+        if (x.threshold) {
+            bool wasBelow = oldQuantity < x.level;
+            bool isBelow = newQuantity < x.level;
+            if (wasBelow == isBelow) {
+                continue;
+            }
+        }
+
+        // The callback may remove itself, so it is kept alive for the call
+        int id = x.id;
+        shared_ptr<resourcecallback> callback = x.callback;
+        (*callback)(resourceName, oldQuantity, newQuantity);
+
+        if (generation != watcherGeneration) {
+            generation = watcherGeneration;
+            item = watchers.find(resourceName);
+            if (item == watchers.end()) {
+                return;
+            }
+            list = &item->second;
+            i = upper_bound(list->begin(), list->end(), id,
+                            [](int value, const watcher& w) {
+                                return value < w.id;
+                            }) - list->begin();
+        }
+    }
+}
+
+// Watch a resource crossing a threshold
+int stockpile::WatchThreshold(const string& resourceName, double level,
+                              resourcecallback callback) {
+    int id = nextWatcherId++;
+    watchers[resourceName].push_back(
+            {id, true, level,
+             make_shared<resourcecallback>(std::move(callback))});
+    watcherGeneration++;
+    return id;
+}
+
+// Watch any change to a set of resources
+int stockpile::WatchChanges(const vector<string>& resourceNames,
+                            resourcecallback callback) {
+    int id = nextWatcherId++;
+    auto shared = make_shared<resourcecallback>(std::move(callback));
+    for (auto& name : resourceNames) {
+        watchers[name].push_back({id, false, 0, shared});
+    }
+    watcherGeneration++;
+    return id;
+}
+
+// Remove a watcher
+bool stockpile::Unwatch(int id) {
+    bool removed = false;
+    for (auto item = watchers.begin(); item != watchers.end();) {
+        vector<watcher>& list = item->second;
+        for (size_t i = 0; i < list.size();) {
+            if (list[i].id == id) {
+                list.erase(list.begin() + i);
+                removed = true;
+            }
+            else {
+                i++;
+            }
+        }
+        if (list.empty()) {
+            item = watchers.erase(item);
+        }
+        else {
+            ++item;
+        }
+    }
+    if (removed) {
+        watcherGeneration++;
+    }
+    return removed;
+}
+
+// Visit every resource with its quantity
+void stockpile::ForEachResource(
+        const function<void(const string&, double)>& visit) const {
+    for (auto& x : resources) {
+        visit(x.first, x.second);
+    }
+}
+
+// Get the number of resources in the Stockpile
+int stockpile::QueryResourceCount() const {
+    return resources.QuerySize();
+}
+
+// Overloaded Arithmetic Operator
+// Adds the quantities of another Stockpile.
+stockpile& stockpile::operator+=(const stockpile& other) {
+    if (QueryObserved()) {
+        for (auto& x : other.resources) {
+            IncreaseResource(x.first, x.second);
+        }
+        return *this;
+    }
+
+    resources.Reserve(resources.QuerySize() + other.resources.QuerySize());
+    for (auto& x : other.resources) {
+        resources.FindOrInsert(x.first) += x.second;
+    }
+    return *this;
+}
+
+// Overloaded Arithmetic Operator
+// Subtracts the quantities of another Stockpile if all of them are covered.
+stockpile& stockpile::operator-=(const stockpile& other) {
+    // Covers skips negative entries, which may name a missing resource
+    for (auto& x : other.resources) {
+        if (x.second < 0) {
+            throw invalid_argument("Cannot subtract a negative quantity of " +
+                                   x.first + ".");
+        }
+    }
+    if (!Covers(other)) {
+        throw runtime_error("Insufficient resources to subtract.");
+    }
+
+    for (auto& x : other.resources) {
+        if (x.second == 0) {
+            continue;
+        }
+        if (QueryObserved()) {
+            IncreaseResource(x.first, -x.second);
+        }
+        else {
+            *resources.Find(x.first) -= x.second;
+        }
+    }
+    return *this;
+}
+
+// Overloaded Arithmetic Operator
+// Scales every quantity by a factor.
+stockpile& stockpile::operator*=(double factor) {
+    if (factor < 0) {
+        throw invalid_argument("Scale factor cannot be negative.");
+    }
+
+    if (!QueryObserved()) {
+        for (auto& x : resources) {
+            x.second *= factor;
+        }
+        return *this;
+    }
+
+    // Watchers may add resources, so the deltas are taken before any change
+    vector<pair<string, double>> deltas;
+    deltas.reserve(resources.QuerySize());
+    for (auto& x : resources) {
+        deltas.emplace_back(x.first, x.second * factor - x.second);
+    }
+    for (auto& x : deltas) {
+        IncreaseResource(x.first, x.second);
+    }
+    return *this;
+}
+
+// Elementwise minimum of two Stockpiles
+stockpile stockpile::Min(const stockpile& other) const {
+    stockpile result;
+    result.resources.Reserve(resources.QuerySize());
+    for (auto& x : resources) {
+        const double* bound = other.resources.Find(x.first);
+        result.resources.FindOrInsert(x.first) =
+                bound != nullptr ? min(x.second, *bound) : 0;
+    }
+    return result;
+}
+
+// Check if this Stockpile covers a set of requirements
+bool stockpile::Covers(const stockpile& requirements) const {
+    for (auto& x : requirements.resources) {
+        if (x.second <= 0) {
+            continue;
+        }
+        const double* quantity = resources.Find(x.first);
+        if (quantity == nullptr || *quantity < x.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Stream a report of the resources
+string stockpile::Report(ostream& output, const reportoptions& options) const {
+    return Report([&output](const char* chunk, size_t length) {
+        output.write(chunk, length);
+    }, options);
+}
+
+// Stream a report of the resources to a function
+// Selects the matching entries, orders only the ones to be printed, and
+// writes them through a fixed buffer.
+string stockpile::Report(const reportwriter& write,
+                         const reportoptions& options) const {
+    typedef const resourcemap::entry* entry;
+    vector<entry> selected;
+    bool useCursor = options.sorted && !options.after.empty();
+
+    for (const auto& x : resources) {
+        if (x.first.compare(0, options.prefix.size(), options.prefix) != 0) {
+            continue;
+        }
+        if (useCursor && x.first <= options.after) {
+            continue;
+        }
+        selected.push_back(&x);
+    }
+
+    size_t count = selected.size();
+    if (options.topK > 0 && (size_t) options.topK < count) {
+        count = options.topK;
+    }
+    if (options.limit > 0 && (size_t) options.limit < count) {
+        count = options.limit;
+    }
+
+    if (options.topK > 0) {
+        partial_sort(selected.begin(), selected.begin() + count,
+                     selected.end(), [](entry a, entry b) {
+            return a->second > b->second ||
+                   (a->second == b->second && a->first < b->first);
+        });
+    }
+    else if (options.sorted) {
+        partial_sort(selected.begin(), selected.begin() + count,
+                     selected.end(), [](entry a, entry b) {
+            return a->first < b->first;
+        });
+    }
+
+    char buffer[4096];
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        const string& name = selected[i]->first;
+        if (used + 32 + name.size() + 2 > sizeof(buffer)) {
+            write(buffer, used);
+            used = 0;
+        }
+        if (32 + name.size() + 2 > sizeof(buffer)) {
+            string line = to_string(selected[i]->second) + " " + name + "\n";
+            write(line.data(), line.size());
+            continue;
+        }
+        used = to_chars(buffer + used, buffer + used + 32,
+                        selected[i]->second).ptr - buffer;
+        buffer[used++] = ' ';
+        memcpy(buffer + used, name.data(), name.size());
+        used += name.size();
+        buffer[used++] = '\n';
+    }
+    if (used > 0) {
+        write(buffer, used);
+    }
+
+    if (options.sorted && options.topK == 0 && count < selected.size()) {
+        return selected[count - 1]->first;
+    }
+    return "";
+}
+
+// Freeze the set of resources
+void stockpile::Freeze() {
+    resources.Freeze();
+}
+
+// Allow new resources again
+void stockpile::Thaw() {
+    resources.Thaw();
+}
+
+// Check if the set of resources is frozen
+bool stockpile::QueryFrozen() const {
+    return resources.QueryFrozen();
+}
@@ -5,11 +5,35 @@
 
 #ifndef P4_STOCKPILE_H
 #define P4_STOCKPILE_H
+#include <functional>
 #include <iostream>
+#include "resourcemap.h"
+#include <memory>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 using namespace std;
 
+class journal;
+class writeaheadlog;
+class sharedstockpile;
+
+// Called with the resource name, the old and the new quantity.
+typedef function<void(const string&, double, double)> resourcecallback;
+
+// Called with each chunk of a report.
+typedef function<void(const char*, size_t)> reportwriter;
+
+// The selection and order of the resources in a report.
+struct reportoptions {
+    bool sorted = false;    // Order by resource name
+    string prefix;          // Only resources whose name starts with this
+    string after;           // Only resources sorted after this cursor
+    int limit = 0;          // At most this many lines; 0 means no limit
+    int topK = 0;           // Only the K largest quantities, largest first
+};
+
 // The Stockpile class simulates a stockpile consisting of multiple
 // resource names and quantities.
 // Class Invariants:
@@ -21,7 +45,30 @@ using namespace std;
 
 class stockpile {
 private:
-    unordered_map<string, double> resources;
+    resourcemap resources;
+    shared_ptr<journal> eventLog;
+    shared_ptr<writeaheadlog> durableLog;
+    unsigned long long lastSequence = 0;
+    shared_ptr<sharedstockpile> sharedView;
+
+    struct watcher {
+        int id;
+        bool threshold;
+        double level;
+        shared_ptr<resourcecallback> callback;
+    };
+    unordered_map<string, vector<watcher>> watchers;
+    int nextWatcherId = 1;
+    unsigned long watcherGeneration = 0;
+
+    void CheckAssignable() const;
+    // Throw if a log or mirror is attached, since assigning would bypass it
+
+    bool QueryObserved() const;
+    // Check if any log, mirror or watcher has to see every single mutation
+
+    void Notify(const string&, double, double);
+    // Call the watchers of a resource whose quantity has changed
 
 public:
     stockpile();
@@ -61,13 +108,20 @@ public:
     stockpile& operator=(const stockpile&);
     // Overloaded Constructor
     // Explanation:     Assigns one Stockpile to another using copy semantics.
+    //                  Watchers are called for every quantity that changed.
     // Precondition:    The parameter is a valid, existing Stockpile object.
+    //                  No Journal, WriteAheadLog or SharedStockpile is
+    //                  attached to this Stockpile; otherwise a logic_error
+    //                  is thrown.
     // Postcondition:   The original Stockpile is a copy of the given one.
 
-    stockpile& operator=(stockpile&&) noexcept;
+    stockpile& operator=(stockpile&&);
     // Move Assignment Operator
     // Explanation:     Assigns one Stockpile to another using move semantics.
     // Precondition:    The parameter is a valid, existing Stockpile object.
+    //                  No Journal, WriteAheadLog or SharedStockpile is
+    //                  attached to this Stockpile; otherwise a logic_error
+    //                  is thrown.
     // Postcondition:   The new Stockpile takes ownership of parameter's
     //                  resources.
 
@@ -78,7 +132,7 @@ public:
     // Postcondition:   Return a string containing all the resource names and
     //                  quantities.
 
-    int QueryQuantity(const string&) const;
+    int QueryQuantity(string_view) const;
     // Get the quantity of the specific resource
     // Explanation:     Return the quantity of the specific resource.
     // Precondition:    None.
@@ -88,7 +142,7 @@ public:
     void IncreaseResource(const string&, double);
     // Increase the quantity of the specific resource
     // Explanation:     Increase the quantity of the specific resource.
-    // Precondition:    None.
+    // Precondition:    The resource is in the Stockpile if it is frozen.
     // Postcondition:   The quantity of the specific resource is increased.
 
     bool DecreaseResource(const string&, int);
@@ -98,12 +152,158 @@ public:
     // Postcondition:   If the resource is in the Stockpile and the quantity
     //                  is valid, it gets decreased.
 
-    bool CheckMaterial(string&, int);
+    bool CheckMaterial(string_view, int) const;
     // Check if the stockpile has sufficient quantity of parameter resource
     // Explanation:     Check if the Stockpile holds sufficient quantity of
     //                  the specific resource.
     // Precondition:    None.
     // Postcondition:   Return the boolean result.
+
+    void Freeze();
+    // Freeze the set of resources
+    // Explanation:     Builds a minimal perfect hash over the resource names,
+    //                  so a lookup is one hash and one array load, and
+    //                  unknown names are rejected by a stored fingerprint.
+    //                  The build is linear in the number of resources; on
+    //                  one core it takes under a second up to about three
+    //                  million names, and about four seconds for ten million.
+    // Precondition:    None.
+    // Postcondition:   Quantities can still change, but increasing a
+    //                  resource that is not in the Stockpile throws an
+    //                  out_of_range exception until Thaw is called.
+
+    void Thaw();
+    // Allow new resources again
+    // Explanation:     Moves the resources back into the regular hash table.
+    // Precondition:    None.
+    // Postcondition:   The Stockpile accepts new resources.
+
+    bool QueryFrozen() const;
+    // Check if the set of resources is frozen
+
+    void ForEachResource(const function<void(const string&, double)>&) const;
+    // Visit every resource with its quantity
+    // Explanation:     Calls the function once for every resource in the
+    //                  Stockpile, in unspecified order.
+    // Precondition:    The function does not modify this Stockpile.
+    // Postcondition:   The Stockpile is not modified.
+
+    int QueryResourceCount() const;
+    // Get the number of resources in the Stockpile
+
+    stockpile& operator+=(const stockpile&);
+    // Overloaded Arithmetic Operator
+    // Explanation:     Adds every quantity of the parameter to this
+    //                  Stockpile.
+    // Precondition:    None.
+    // Postcondition:   This Stockpile holds the sum of both.
+
+    stockpile& operator-=(const stockpile&);
+    // Overloaded Arithmetic Operator
+    // Explanation:     Subtracts every quantity of the parameter, such as a
+    //                  bill of materials, from this Stockpile.
+    // Precondition:    The parameter has no negative quantity; otherwise an
+    //                  invalid_argument is thrown. This Stockpile covers the
+    //                  parameter; otherwise a runtime_error is thrown.
+    // Postcondition:   This Stockpile holds the difference, or is unchanged
+    //                  if either check failed.
+
+    stockpile& operator*=(double);
+    // Overloaded Arithmetic Operator
+    // Explanation:     Scales every quantity by the factor.
+    // Precondition:    The factor is not negative.
+    // Postcondition:   Every quantity is multiplied by the factor.
+
+    stockpile Min(const stockpile&) const;
+    // Elementwise minimum of two Stockpiles
+    // Explanation:     Returns the resources of this Stockpile, each with the
+    //                  smaller of both quantities; a resource missing from
+    //                  the parameter counts as 0.
+    // Precondition:    None.
+    // Postcondition:   Neither Stockpile is modified.
+
+    bool Covers(const stockpile&) const;
+    // Check if this Stockpile covers a set of requirements
+    // Explanation:     Checks that every quantity of the parameter is
+    //                  available in this Stockpile.
+    // Precondition:    None.
+    // Postcondition:   Return the boolean result.
+
+    string Report(ostream&, const reportoptions& = reportoptions()) const;
+    // Stream a report of the resources
+    // Explanation:     Writes one line per selected resource, quantity first,
+    //                  in chunks instead of one big string.
+    // Precondition:    A cursor is only used for sorted reports.
+    // Postcondition:   Return the cursor for the next page of a sorted
+    //                  report, or an empty string if nothing is left.
+
+    string Report(const reportwriter&,
+                  const reportoptions& = reportoptions()) const;
+    // Stream a report of the resources to a function
+    // Explanation:     Same as above, but hands every chunk to the function.
+    // Precondition:    A cursor is only used for sorted reports.
+    // Postcondition:   Return the cursor for the next page of a sorted
+    //                  report, or an empty string if nothing is left.
+
+    int WatchThreshold(const string&, double, resourcecallback);
+    // Watch a resource crossing a threshold
+    // Explanation:     Calls the function whenever a mutation moves the
+    //                  quantity of the resource from below the threshold to
+    //                  at or above it, or the other way round.
+    // Precondition:    None.
+    // Postcondition:   Return the id of the watcher.
+
+    int WatchChanges(const vector<string>&, resourcecallback);
+    // Watch any change to a set of resources
+    // Explanation:     Calls the function after every mutation of any of the
+    //                  resources.
+    // Precondition:    None.
+    // Postcondition:   Return the id of the watcher.
+
+    bool Unwatch(int);
+    // Remove a watcher
+    // Explanation:     Stops calling the watcher with the given id.
+    // Precondition:    None.
+    // Postcondition:   Return whether a watcher with the id was removed.
+
+    void AttachJournal(shared_ptr<journal>);
+    // Record every mutation in a Journal
+    // Explanation:     Takes a snapshot of the current resources and appends
+    //                  an event to the Journal for every later increase and
+    //                  successful decrease. A null pointer detaches it.
+    // Precondition:    None.
+    // Postcondition:   The Journal receives the mutations of this Stockpile.
+    //                  Copies of the Stockpile are not attached.
+
+    void AttachWriteAheadLog(shared_ptr<writeaheadlog>);
+    // Make every mutation durable through a WriteAheadLog
+    // Explanation:     Appends every later increase and successful decrease
+    //                  to the log before applying it. If the log file was
+    //                  empty, the current resources are logged first. A null
+    //                  pointer detaches it.
+    // Precondition:    The Stockpile was recovered from the same log file if
+    //                  the file was not empty.
+    // Postcondition:   Mutations are logged; callers that need them durable
+    //                  wait on the log.
+
+    unsigned long long QueryLastSequence() const;
+    // Get the WriteAheadLog sequence number of the last mutation
+    // Explanation:     Callers that need a mutation durable pass the number
+    //                  to the log's WaitDurable, which lets many mutations
+    //                  share one group commit.
+    // Precondition:    None.
+    // Postcondition:   Return the sequence number, or 0 if no mutation of
+    //                  this Stockpile was logged.
+
+    void AttachSharedMemory(shared_ptr<sharedstockpile>);
+    // Mirror every quantity into a shared memory segment
+    // Explanation:     Publishes the current resources to the segment and
+    //                  every later change, so other processes can read the
+    //                  quantities directly. A null pointer detaches it.
+    // Precondition:    The SharedStockpile is a writer with room for all the
+    //                  resources.
+    // Postcondition:   The segment mirrors this Stockpile; if publishing
+    //                  fails, the segment is detached and the error rethrown.
 };
 
 
@@ -0,0 +1,560 @@
+// AUTHOR:      Hongru He
+// FILENAME:    throughputsolver.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "throughputsolver.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   Variables 0 to n - 1 are the recipe columns and n to n + m - 1 the
+//      slacks of the m material rows; the column of a slack is a unit
+//      vector.
+// 2.   inverse holds B^-1 row by row, so inverse[r * m + i] is entry (r, i);
+//      basic[r] is the value of basis[r] and position[k] is the row of
+//      variable k in the basis, or -1.
+// 3.   Pivots update the inverse in place; after max(REINVERT, m) pivots it
+//      is rebuilt from the basis columns to keep rounding errors small. The
+//      O(m^3) rebuild then costs no more per pivot than a pivot itself.
+// 4.   Primal pricing takes the largest reduced cost and falls back to
+//      Bland's rule after a run of degenerate pivots, so it cannot cycle.
+
+namespace {
+    const double EPSILON = 1e-9;
+    const int REINVERT = 64;
+    const int DEGENERATELIMIT = 50;
+}
+
+// Overloaded Constructor
+throughputsolver::throughputsolver(const recipecatalog& recipes,
+                                   yieldmode yieldMode) {
+    catalog = &recipes;
+    mode = yieldMode;
+    pivotsSinceReinvert = 0;
+    iterations = 0;
+    solved = false;
+}
+
+// Build
+// Walks from the weighted materials to their producers, and on through the
+// inputs of those producers, adding each recipe once
+void throughputsolver::Build(const unordered_map<string, double>& weights) {
+    recipeIds.clear();
+    columns.clear();
+    cost.clear();
+    materials.clear();
+    rowIds.clear();
+
+    vector<bool> queued;
+    deque<string> pending;
+    auto intern = [this, &queued](const string& material) {
+        auto item = rowIds.find(material);
+        if (item != rowIds.end()) {
+            return item->second;
+        }
+        int row = (int) materials.size();
+        rowIds.emplace(material, row);
+        materials.push_back(material);
+        queued.push_back(false);
+        return row;
+    };
+    auto enqueue = [&queued, &pending, &intern](const string& material) {
+        int row = intern(material);
+        if (!queued[row]) {
+            queued[row] = true;
+            pending.push_back(material);
+        }
+        return row;
+    };
+
+    for (const auto& weight : weights) {
+        if (weight.second != 0) {
+            enqueue(weight.first);
+        }
+    }
+
+    vector<bool> added(catalog->QueryIdLimit(), false);
+    while (!pending.empty()) {
+        string material = std::move(pending.front());
+        pending.pop_front();
+        for (int id : catalog->QueryProducers(material)) {
+            if (added[id]) {
+                continue;
+            }
+            added[id] = true;
+            recipeIds.push_back(id);
+        }
+        // Producers found above are expanded in the order they were added
+        while (columns.size() < recipeIds.size()) {
+            const formula& recipe = catalog->QueryFormula(
+                    recipeIds[columns.size()]);
+            double yield = craftabilitysolver::QueryYield(recipe, mode);
+            map<int, double> entries;
+            for (int i = 0; i < recipe.QueryInputSize(); i++) {
+                entries[enqueue(recipe.QueryInputMaterial(i))] +=
+                        recipe.QueryInputNumber(i);
+            }
+            for (int j = 0; j < recipe.QueryOutputSize(); j++) {
+                entries[intern(recipe.QueryOutputMaterial(j))] -=
+                        yield * recipe.QueryOutputNumber(j);
+            }
+
+            column newColumn;
+            double value = 0;
+            for (const auto& entry : entries) {
+                if (entry.second == 0) {
+                    continue;
+                }
+                newColumn.rows.push_back(entry.first);
+                newColumn.values.push_back(entry.second);
+                auto weight = weights.find(materials[entry.first]);
+                if (weight != weights.end()) {
+                    value -= weight->second * entry.second;
+                }
+            }
+            columns.push_back(std::move(newColumn));
+            cost.push_back(value);
+        }
+    }
+}
+
+// Read Stock
+void throughputsolver::ReadStock(const stockpile& resources) {
+    rhs.assign(materials.size(), 0);
+    resources.ForEachResource([this](const string& name, double quantity) {
+        auto item = rowIds.find(name);
+        if (item != rowIds.end()) {
+            rhs[item->second] = max(quantity, 0.0);
+        }
+    });
+}
+
+// Cold Start
+// Puts every slack in the basis, where the inverse is the identity
+void throughputsolver::ColdStart() {
+    int m = (int) materials.size();
+    int n = (int) columns.size();
+    basis.resize(m);
+    position.assign(n + m, -1);
+    inverse.assign((size_t) m * m, 0);
+    for (int r = 0; r < m; r++) {
+        basis[r] = n + r;
+        position[n + r] = r;
+        inverse[(size_t) r * m + r] = 1;
+    }
+    pivotsSinceReinvert = 0;
+    ComputeBasic();
+}
+
+// Compute Basic
+void throughputsolver::ComputeBasic() {
+    int m = (int) materials.size();
+    basic.assign(m, 0);
+    for (int r = 0; r < m; r++) {
+        const double* row = &inverse[(size_t) r * m];
+        double value = 0;
+        for (int i = 0; i < m; i++) {
+            value += row[i] * rhs[i];
+        }
+        basic[r] = value;
+    }
+}
+
+// Compute Duals
+// y = c_B B^-1
+vector<double> throughputsolver::ComputeDuals() const {
+    int m = (int) materials.size();
+    int n = (int) columns.size();
+    vector<double> duals(m, 0);
+    for (int r = 0; r < m; r++) {
+        double basicCost = basis[r] < n ? cost[basis[r]] : 0;
+        if (basicCost == 0) {
+            continue;
+        }
+        const double* row = &inverse[(size_t) r * m];
+        for (int i = 0; i < m; i++) {
+            duals[i] += basicCost * row[i];
+        }
+    }
+    return duals;
+}
+
+// Reduced Cost
+double throughputsolver::ReducedCost(int variable,
+                                     const vector<double>& duals) const {
+    int n = (int) columns.size();
+    if (variable >= n) {
+        return -duals[variable - n];
+    }
+    double result = cost[variable];
+    const column& target = columns[variable];
+    for (size_t e = 0; e < target.rows.size(); e++) {
+        result -= duals[target.rows[e]] * target.values[e];
+    }
+    return result;
+}
+
+// Row Times Column
+double throughputsolver::RowTimesColumn(const double* row,
+                                        int variable) const {
+    int n = (int) columns.size();
+    if (variable >= n) {
+        return row[variable - n];
+    }
+    double result = 0;
+    const column& target = columns[variable];
+    for (size_t e = 0; e < target.rows.size(); e++) {
+        result += row[target.rows[e]] * target.values[e];
+    }
+    return result;
+}
+
+// Transform
+// u = B^-1 a_k
+vector<double> throughputsolver::Transform(int variable) const {
+    int m = (int) materials.size();
+    vector<double> result(m);
+    for (int r = 0; r < m; r++) {
+        result[r] = RowTimesColumn(&inverse[(size_t) r * m], variable);
+    }
+    return result;
+}
+
+// Pivot
+// Gauss-Jordan step on the inverse and the basic values
+void throughputsolver::Pivot(int leaving, int entering,
+                             const vector<double>& direction) {
+    int m = (int) materials.size();
+    double* pivotRow = &inverse[(size_t) leaving * m];
+    double pivot = direction[leaving];
+    for (int i = 0; i < m; i++) {
+        pivotRow[i] /= pivot;
+    }
+    basic[leaving] /= pivot;
+
+    for (int r = 0; r < m; r++) {
+        double factor = direction[r];
+        if (r == leaving || factor == 0) {
+            continue;
+        }
+        double* row = &inverse[(size_t) r * m];
+        for (int i = 0; i < m; i++) {
+            row[i] -= factor * pivotRow[i];
+        }
+        basic[r] -= factor * basic[leaving];
+    }
+
+    position[basis[leaving]] = -1;
+    basis[leaving] = entering;
+    position[entering] = leaving;
+    if (++pivotsSinceReinvert >= max(REINVERT, m)) {
+        Reinvert();
+    }
+}
+
+// Reinvert
+// Inverts the basis matrix from scratch with partial pivoting
+void throughputsolver::Reinvert() {
+    int m = (int) materials.size();
+    int n = (int) columns.size();
+    vector<double> matrix((size_t) m * m, 0);
+    for (int r = 0; r < m; r++) {
+        if (basis[r] >= n) {
+            matrix[(size_t) (basis[r] - n) * m + r] = 1;
+            continue;
+        }
+        const column& target = columns[basis[r]];
+        for (size_t e = 0; e < target.rows.size(); e++) {
+            matrix[(size_t) target.rows[e] * m + r] = target.values[e];
+        }
+    }
+
+    inverse.assign((size_t) m * m, 0);
+    for (int r = 0; r < m; r++) {
+        inverse[(size_t) r * m + r] = 1;
+    }
+    for (int c = 0; c < m; c++) {
+        int best = c;
+        for (int r = c + 1; r < m; r++) {
+            if (fabs(matrix[(size_t) r * m + c]) >
+                fabs(matrix[(size_t) best * m + c])) {
+                best = r;
+            }
+        }
+        if (fabs(matrix[(size_t) best * m + c]) < 1e-12) {
+            throw runtime_error("The simplex basis became singular.");
+        }
+        if (best != c) {
+            swap_ranges(matrix.begin() + (size_t) best * m,
+                        matrix.begin() + (size_t) (best + 1) * m,
+                        matrix.begin() + (size_t) c * m);
+            swap_ranges(inverse.begin() + (size_t) best * m,
+                        inverse.begin() + (size_t) (best + 1) * m,
+                        inverse.begin() + (size_t) c * m);
+        }
+        double pivot = matrix[(size_t) c * m + c];
+        for (int i = 0; i < m; i++) {
+            matrix[(size_t) c * m + i] /= pivot;
+            inverse[(size_t) c * m + i] /= pivot;
+        }
+        for (int r = 0; r < m; r++) {
+            double factor = matrix[(size_t) r * m + c];
+            if (r == c || factor == 0) {
+                continue;
+            }
+            for (int i = 0; i < m; i++) {
+                matrix[(size_t) r * m + i] -= factor *
+                                              matrix[(size_t) c * m + i];
+                inverse[(size_t) r * m + i] -= factor *
+                                               inverse[(size_t) c * m + i];
+            }
+        }
+    }
+    pivotsSinceReinvert = 0;
+    ComputeBasic();
+}
+
+// Primal
+// Pivots in the variable with the best reduced cost until none improves
+void throughputsolver::Primal() {
+    int m = (int) materials.size();
+    int n = (int) columns.size();
+    int limit = 50 * (n + m) + 1000;
+    int degenerate = 0;
+    while (true) {
+        vector<double> duals = ComputeDuals();
+        bool bland = degenerate > DEGENERATELIMIT;
+        int entering = -1;
+        double best = EPSILON;
+        for (int k = 0; k < n + m; k++) {
+            if (position[k] >= 0) {
+                continue;
+            }
+            double reduced = ReducedCost(k, duals);
+            if (reduced > best) {
+                entering = k;
+                best = reduced;
+                if (bland) {
+                    break;
+                }
+            }
+        }
+        if (entering < 0) {
+            return;
+        }
+        if (++iterations > limit) {
+            throw runtime_error("The simplex method did not converge.");
+        }
+
+        vector<double> direction = Transform(entering);
+        int leaving = -1;
+        double minRatio = numeric_limits<double>::infinity();
+        for (int r = 0; r < m; r++) {
+            if (direction[r] <= EPSILON) {
+                continue;
+            }
+            double ratio = max(basic[r], 0.0) / direction[r];
+            if (ratio < minRatio - EPSILON ||
+                (ratio < minRatio + EPSILON && leaving >= 0 &&
+                 basis[r] < basis[leaving])) {
+                minRatio = min(minRatio, ratio);
+                leaving = r;
+            }
+        }
+        if (leaving < 0) {
+            throw runtime_error("The output is unbounded.");
+        }
+
+        degenerate = minRatio < EPSILON ? degenerate + 1 : 0;
+        Pivot(leaving, entering, direction);
+    }
+}
+
+// Dual
+// Pivots out the most negative basic value until the basis is feasible,
+// keeping every reduced cost non-positive
+void throughputsolver::Dual() {
+    int m = (int) materials.size();
+    int n = (int) columns.size();
+    int limit = 50 * (n + m) + 1000;
+    while (true) {
+        int leaving = -1;
+        double lowest = -EPSILON;
+        for (int r = 0; r < m; r++) {
+            if (basic[r] < lowest) {
+                lowest = basic[r];
+                leaving = r;
+            }
+        }
+        if (leaving < 0) {
+            return;
+        }
+        if (++iterations > limit) {
+            throw runtime_error("The simplex method did not converge.");
+        }
+
+        vector<double> duals = ComputeDuals();
+        const double* row = &inverse[(size_t) leaving * m];
+        int entering = -1;
+        double minRatio = numeric_limits<double>::infinity();
+        for (int k = 0; k < n + m; k++) {
+            if (position[k] >= 0) {
+                continue;
+            }
+            double alpha = RowTimesColumn(row, k);
+            if (alpha >= -EPSILON) {
+                continue;
+            }
+            double ratio = min(ReducedCost(k, duals), 0.0) / alpha;
+            if (ratio < minRatio) {
+                minRatio = ratio;
+                entering = k;
+            }
+        }
+        if (entering < 0) {
+            throw runtime_error("The stock admits no feasible mix.");
+        }
+        Pivot(leaving, entering, Transform(entering));
+    }
+}
+
+// Result
+// Reads the fractional counts, rounds them down, repairs any row the
+// rounding broke and then fills the remaining stock greedily
+throughputresult throughputsolver::Result() const {
+    int m = (int) materials.size();
+    int n = (int) columns.size();
+    throughputresult result;
+    result.iterations = iterations;
+
+    vector<long long> counts(n, 0);
+    for (int j = 0; j < n; j++) {
+        double value = position[j] >= 0 ? max(basic[position[j]], 0.0) : 0;
+        if (value > EPSILON) {
+            result.crafts.push_back({recipeIds[j], value});
+            result.objective += cost[j] * value;
+        }
+        counts[j] = (long long) floor(value + EPSILON);
+    }
+
+    vector<double> slack = rhs;
+    for (int j = 0; j < n; j++) {
+        for (size_t e = 0; e < columns[j].rows.size(); e++) {
+            slack[columns[j].rows[e]] -= columns[j].values[e] * counts[j];
+        }
+    }
+
+    // Rounding down a producer can starve its consumers; drop consumer
+    // crafts until every row holds again
+    for (int i = 0; i < m; i++) {
+        if (slack[i] >= -EPSILON) {
+            continue;
+        }
+        int worst = -1;
+        double worstUse = 0;
+        for (int j = 0; j < n; j++) {
+            if (counts[j] == 0) {
+                continue;
+            }
+            for (size_t e = 0; e < columns[j].rows.size(); e++) {
+                if (columns[j].rows[e] == i &&
+                    columns[j].values[e] > worstUse) {
+                    worst = j;
+                    worstUse = columns[j].values[e];
+                }
+            }
+        }
+        if (worst < 0) {
+            continue;
+        }
+        counts[worst]--;
+        for (size_t e = 0; e < columns[worst].rows.size(); e++) {
+            slack[columns[worst].rows[e]] += columns[worst].values[e];
+        }
+        // Dropping a craft also drops its outputs, so recheck every row
+        i = -1;
+    }
+
+    vector<int> order(n);
+    for (int j = 0; j < n; j++) {
+        order[j] = j;
+    }
+    sort(order.begin(), order.end(), [this](int a, int b) {
+        return cost[a] > cost[b];
+    });
+    for (int j : order) {
+        if (cost[j] <= EPSILON) {
+            break;
+        }
+        long long extra = numeric_limits<long long>::max();
+        for (size_t e = 0; e < columns[j].rows.size(); e++) {
+            if (columns[j].values[e] > EPSILON) {
+                extra = min(extra, (long long) floor(
+                        (slack[columns[j].rows[e]] + EPSILON) /
+                        columns[j].values[e]));
+            }
+        }
+        if (extra <= 0 || extra == numeric_limits<long long>::max()) {
+            continue;
+        }
+        counts[j] += extra;
+        for (size_t e = 0; e < columns[j].rows.size(); e++) {
+            slack[columns[j].rows[e]] -= columns[j].values[e] * extra;
+        }
+    }
+
+    for (int j = 0; j < n; j++) {
+        if (counts[j] > 0) {
+            result.integerCrafts.push_back({recipeIds[j], counts[j]});
+            result.integerObjective += cost[j] * counts[j];
+        }
+    }
+    return result;
+}
+
+// Maximize
+throughputresult throughputsolver::Maximize(const string& material,
+                                            const stockpile& resources) {
+    return Maximize(unordered_map<string, double>{{material, 1}}, resources);
+}
+
+// Maximize
+// Builds the program for the weights and solves it from the slack basis
+throughputresult throughputsolver::Maximize(
+        const unordered_map<string, double>& weights,
+        const stockpile& resources) {
+    solved = false;
+    Build(weights);
+    ReadStock(resources);
+    ColdStart();
+    iterations = 0;
+    Primal();
+    ComputeBasic();
+    solved = true;
+    return Result();
+}
+
+// Resolve
+// Keeps the optimal basis of the last solve and restores feasibility for
+// the new stock with dual simplex pivots
+throughputresult throughputsolver::Resolve(const stockpile& resources) {
+    if (!solved) {
+        throw logic_error("There is no solved program to warm-start from.");
+    }
+    solved = false;
+    ReadStock(resources);
+    ComputeBasic();
+    iterations = 0;
+    Dual();
+    Primal();
+    ComputeBasic();
+    solved = true;
+    return Result();
+}
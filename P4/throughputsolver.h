@@ -0,0 +1,138 @@
+// AUTHOR:      Hongru He
+// FILENAME:    throughputsolver.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_THROUGHPUTSOLVER_H
+#define P4_THROUGHPUTSOLVER_H
+#include "craftabilitysolver.h"
+#include "recipecatalog.h"
+#include "stockpile.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The result of a ThroughputSolver run. Craft counts are listed by catalog
+// id and only for recipes crafted a positive number of times.
+struct throughputresult {
+    double objective = 0;
+    vector<pair<int, double>> crafts;
+    double integerObjective = 0;
+    vector<pair<int, long long>> integerCrafts;
+    int iterations = 0;
+};
+
+// The ThroughputSolver class finds the mix of recipes that maximizes the
+// net output of a target material, or a weighted value of several, from a
+// Stockpile. It solves the linear program
+//     maximize    w . (yield * P - C) x
+//     subject to  (C - yield * P) x <= stock,  x >= 0
+// with a revised simplex method on the sparse recipe columns.
+// Class Invariants:
+// 1.   Only recipes that can contribute to a weighted material, directly or
+//      through intermediates, become columns; only their materials become
+//      rows.
+// 2.   The stock is never negative, so crafting nothing is feasible and the
+//      slack basis is a valid cold start.
+// 3.   After a solve, the basis stays optimal for the objective, so a
+//      Resolve with new stock only needs dual simplex pivots.
+// 4.   The integer counts are always feasible for the stock.
+
+class throughputsolver {
+private:
+    struct column {
+        vector<int> rows;
+        vector<double> values;
+    };
+
+    const recipecatalog* catalog;
+    yieldmode mode;
+    vector<int> recipeIds;
+    vector<column> columns;
+    vector<double> cost;
+    vector<string> materials;
+    unordered_map<string, int> rowIds;
+    vector<double> rhs;
+    vector<int> basis;
+    vector<int> position;
+    vector<double> inverse;
+    vector<double> basic;
+    int pivotsSinceReinvert;
+    int iterations;
+    bool solved;
+
+    void Build(const unordered_map<string, double>&);
+    // Collect the columns that can reach a weighted material
+
+    void ReadStock(const stockpile&);
+    // Fill the right-hand side from the Stockpile
+
+    void ColdStart();
+    // Start from the slack basis
+
+    void ComputeBasic();
+    // Recompute the basic values from the inverse and the right-hand side
+
+    vector<double> ComputeDuals() const;
+    // Compute the simplex multipliers of the current basis
+
+    double ReducedCost(int, const vector<double>&) const;
+    // Get the reduced cost of a variable
+
+    double RowTimesColumn(const double*, int) const;
+    // Multiply a row of the inverse with the column of a variable
+
+    vector<double> Transform(int) const;
+    // Compute the inverse times the column of a variable
+
+    void Pivot(int, int, const vector<double>&);
+    // Bring a variable into the basis at a row
+
+    void Reinvert();
+    // Rebuild the inverse from the basis columns
+
+    void Primal();
+    // Run primal simplex iterations until optimal
+
+    void Dual();
+    // Run dual simplex iterations until primal feasible
+
+    throughputresult Result() const;
+    // Read the fractional solution and repair a rounded integer one
+
+public:
+    explicit throughputsolver(const recipecatalog&,
+                              yieldmode = yieldmode::Expected);
+    // Overloaded Constructor
+    // Explanation:     Initializes a ThroughputSolver over a catalog;
+    //                  outputs count with their yield under the mode.
+    // Precondition:    The catalog outlives the solver.
+    // Postcondition:   ThroughputSolver object is ready to solve.
+
+    throughputresult Maximize(const string&, const stockpile&);
+    // Maximize the net output of one material
+    // Precondition:    None.
+    // Postcondition:   Return the optimal mix; a runtime_error is thrown if
+    //                  the output is unbounded.
+
+    throughputresult Maximize(const unordered_map<string, double>&,
+                              const stockpile&);
+    // Maximize a weighted value of the net outputs
+    // Precondition:    None.
+    // Postcondition:   Return the optimal mix; a runtime_error is thrown if
+    //                  the value is unbounded.
+
+    throughputresult Resolve(const stockpile&);
+    // Solve the last objective again for new stock
+    // Explanation:     Warm-starts from the last optimal basis.
+    // Precondition:    Maximize was called and the catalog did not change
+    //                  since; otherwise a logic_error is thrown for the
+    //                  first case.
+    // Postcondition:   Return the optimal mix for the new stock.
+};
+
+
+#endif //P4_THROUGHPUTSOLVER_H
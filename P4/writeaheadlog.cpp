@@ -0,0 +1,258 @@
+// AUTHOR:      Hongru He
+// FILENAME:    writeaheadlog.cpp
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#include "writeaheadlog.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Implementation Invariants:
+// 1.   A record is the event type, the name length, the name, the amount and
+//      a checksum of all the previous bytes, so recovery can tell a complete
+//      record from a torn one.
+// 2.   Appending only copies the record into the pending buffer under the
+//      lock; writing and syncing happen on the flusher thread with the lock
+//      released, so one sync covers every record appended meanwhile.
+// 3.   durableSequence only grows, only after a group was written and
+//      synced, and waiters are woken after each group.
+// 4.   Once a write or sync fails, nothing more is written, since records
+//      after a torn one could never be recovered; later appends throw and
+//      pending records are dropped.
+
+// Checksum
+// Computes the FNV-1a hash of a byte range.
+static unsigned int Checksum(const char* data, size_t length) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char) data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Sync File
+// Forces the written data of a file down to storage.
+static bool SyncFile(FILE* file) {
+    if (fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Overloaded Constructor
+writeaheadlog::writeaheadlog(const string& logPath, int records, int delay) {
+    if (records <= 0 || delay < 0) {
+        throw invalid_argument("Group size must be positive and delay cannot "
+                               "be negative.");
+    }
+
+    path = logPath;
+    file = fopen(path.c_str(), "ab");
+    if (file == nullptr) {
+        throw runtime_error("Cannot open " + path + " for appending.");
+    }
+    error_code code;
+    emptyAtOpen = filesystem::file_size(path, code) == 0 || code;
+
+    pendingCount = 0;
+    nextSequence = 1;
+    durableSequence = 0;
+    waitingSequence = 0;
+    groupSize = records;
+    groupDelay = delay;
+    stopping = false;
+    failed = false;
+    flusher = thread(&writeaheadlog::FlushLoop, this);
+}
+
+// Destructor
+writeaheadlog::~writeaheadlog() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    flushNeeded.notify_one();
+    flusher.join();
+    fclose(file);
+}
+
+// Flush Loop
+// Waits for a group to fill up, for its delay to pass or for a waiter, then
+// writes and syncs the whole group at once.
+void writeaheadlog::FlushLoop() {
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        flushNeeded.wait(guard, [this] {
+            return stopping || pendingCount > 0;
+        });
+        if (pendingCount == 0) {
+            break;
+        }
+
+        flushNeeded.wait_for(guard, chrono::microseconds(groupDelay), [this] {
+            return stopping || pendingCount >= groupSize ||
+                   waitingSequence > durableSequence;
+        });
+
+        vector<char> group;
+        group.swap(pending);
+        pendingCount = 0;
+        unsigned long long lastSequence = nextSequence - 1;
+        if (failed) {
+            continue;
+        }
+
+        guard.unlock();
+        bool written = fwrite(group.data(), 1, group.size(), file) ==
+                       group.size() && SyncFile(file);
+        guard.lock();
+
+        if (written) {
+            durableSequence = lastSequence;
+        }
+        else {
+            failed = true;
+        }
+        flushDone.notify_all();
+    }
+}
+
+// Append a mutation record
+unsigned long long writeaheadlog::Append(eventtype type, const string& name,
+                                         double amount) {
+    unsigned int length = name.size();
+    size_t recordSize = 1 + sizeof(length) + length + sizeof(amount) +
+                        sizeof(unsigned int);
+
+    unsigned long long sequence;
+    bool wake;
+    {
+        lock_guard<mutex> guard(lock);
+        if (failed) {
+            throw runtime_error("Cannot write the log to " + path + ".");
+        }
+        size_t start = pending.size();
+        pending.resize(start + recordSize);
+        char* record = pending.data() + start;
+
+        record[0] = (char) type;
+        memcpy(record + 1, &length, sizeof(length));
+        memcpy(record + 1 + sizeof(length), name.data(), length);
+        memcpy(record + 1 + sizeof(length) + length, &amount, sizeof(amount));
+        unsigned int check = Checksum(record, recordSize - sizeof(check));
+        memcpy(record + recordSize - sizeof(check), &check, sizeof(check));
+
+        sequence = nextSequence++;
+        pendingCount++;
+        wake = pendingCount == 1 || pendingCount >= groupSize;
+    }
+    if (wake) {
+        flushNeeded.notify_one();
+    }
+
+    return sequence;
+}
+
+// Wait until a record is durable
+void writeaheadlog::WaitDurable(unsigned long long sequence) {
+    unique_lock<mutex> guard(lock);
+    if (sequence > waitingSequence) {
+        waitingSequence = sequence;
+    }
+    flushNeeded.notify_one();
+    flushDone.wait(guard, [this, sequence] {
+        return durableSequence >= sequence || failed;
+    });
+    if (durableSequence < sequence) {
+        throw runtime_error("Cannot write the log to " + path + ".");
+    }
+}
+
+// Wait until every appended record is durable
+void writeaheadlog::Sync() {
+    WaitDurable(QueryLastSequence());
+}
+
+// Get the sequence number of the last appended record
+unsigned long long writeaheadlog::QueryLastSequence() {
+    lock_guard<mutex> guard(lock);
+    return nextSequence - 1;
+}
+
+// Get the number of records known to be durable
+unsigned long long writeaheadlog::QueryDurableSequence() {
+    lock_guard<mutex> guard(lock);
+    return durableSequence;
+}
+
+// Check if the log file had no records when it was opened
+bool writeaheadlog::QueryEmptyAtOpen() const {
+    return emptyAtOpen;
+}
+
+// Recover
+// Replays complete records and truncates the file after the last of them.
+stockpile writeaheadlog::Recover(const string& logPath) {
+    stockpile recovered;
+    ifstream input(logPath, ios::binary);
+    if (!input) {
+        return recovered;
+    }
+
+    vector<char> content((istreambuf_iterator<char>(input)),
+                         istreambuf_iterator<char>());
+    input.close();
+
+    size_t offset = 0;
+    while (true) {
+        unsigned int length;
+        double amount;
+        unsigned int check;
+        size_t header = 1 + sizeof(length);
+        if (content.size() - offset < header) {
+            break;
+        }
+        memcpy(&length, content.data() + offset + 1, sizeof(length));
+        size_t recordSize = header + length + sizeof(amount) + sizeof(check);
+        if (content.size() - offset < recordSize) {
+            break;
+        }
+
+        const char* record = content.data() + offset;
+        memcpy(&check, record + recordSize - sizeof(check), sizeof(check));
+        if (check != Checksum(record, recordSize - sizeof(check))) {
+            break;
+        }
+        memcpy(&amount, record + header + length, sizeof(amount));
+        string name(record + header, length);
+
+        if ((eventtype) record[0] == eventtype::Increase) {
+            recovered.IncreaseResource(name, amount);
+        }
+        else if ((eventtype) record[0] == eventtype::Decrease) {
+            recovered.DecreaseResource(name, (int) amount);
+        }
+        offset += recordSize;
+    }
+
+    if (offset < content.size()) {
+        filesystem::resize_file(logPath, offset);
+    }
+
+    return recovered;
+}
@@ -0,0 +1,109 @@
+// AUTHOR:      Hongru He
+// FILENAME:    writeaheadlog.h
+// DATE:        10/19/2026
+// VERSION:     V1.0
+
+#ifndef P4_WRITEAHEADLOG_H
+#define P4_WRITEAHEADLOG_H
+#include "journal.h"
+#include "stockpile.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// The WriteAheadLog class makes the mutations of a Stockpile durable by
+// appending them to a file before they are applied, and syncing the file
+// for groups of mutations at once.
+// Class Invariants:
+// 1.   Records are written to the file in the order they are appended, and
+//      every record has a sequence number one above the previous one.
+// 2.   Every record with a sequence number below the durable sequence has
+//      been written and synced to storage.
+// 3.   Only one background thread writes and syncs the file, so callers
+//      never wait on storage unless they ask for durability.
+
+class writeaheadlog {
+private:
+    string path;
+    FILE* file;
+    bool emptyAtOpen;
+    mutex lock;
+    condition_variable flushNeeded;
+    condition_variable flushDone;
+    vector<char> pending;
+    int pendingCount;
+    unsigned long long nextSequence;
+    unsigned long long durableSequence;
+    unsigned long long waitingSequence;
+    int groupSize;
+    int groupDelay;
+    bool stopping;
+    bool failed;
+    thread flusher;
+
+    void FlushLoop();
+    // Write and sync groups of pending records until the log is closed
+
+public:
+    explicit writeaheadlog(const string&, int = 1024, int = 2000);
+    // Overloaded Constructor
+    // Explanation:     Opens the log file for appending and starts the group
+    //                  commit thread. A group is synced once it holds the
+    //                  given number of records or once the given number of
+    //                  microseconds has passed since its first record.
+    // Precondition:    The file is not opened by another log.
+    // Postcondition:   WriteAheadLog object is ready to append records.
+
+    ~writeaheadlog();
+    // Destructor
+    // Explanation:     Syncs every pending record and closes the file.
+    // Precondition:    None.
+    // Postcondition:   All appended records are durable.
+
+    writeaheadlog(const writeaheadlog&) = delete;
+    writeaheadlog& operator=(const writeaheadlog&) = delete;
+
+    unsigned long long Append(eventtype, const string&, double);
+    // Append a mutation record
+    // Explanation:     Queues the record for the next group commit without
+    //                  waiting for storage.
+    // Precondition:    The type is Increase or Decrease, and no earlier
+    //                  write of the log failed; otherwise a runtime_error
+    //                  is thrown.
+    // Postcondition:   Returns the sequence number of the record.
+
+    void WaitDurable(unsigned long long);
+    // Wait until a record is durable
+    // Explanation:     Blocks until the record with the given sequence number
+    //                  and every record before it are synced.
+    // Precondition:    The sequence number was returned by Append.
+    // Postcondition:   The record is durable, or a runtime_error is thrown
+    //                  if the log could not be written.
+
+    void Sync();
+    // Wait until every appended record is durable
+
+    unsigned long long QueryLastSequence();
+    // Get the sequence number of the last appended record, or 0 if none
+
+    unsigned long long QueryDurableSequence();
+    // Get the number of records known to be durable
+
+    bool QueryEmptyAtOpen() const;
+    // Check if the log file had no records when it was opened
+
+    static stockpile Recover(const string&);
+    // Rebuild a Stockpile from a log file
+    // Explanation:     Replays every complete record of the file and cuts
+    //                  off a torn record left by a crash.
+    // Precondition:    The file is not opened by a log.
+    // Postcondition:   Returns the Stockpile as of the last durable record.
+};
+
+
+#endif //P4_WRITEAHEADLOG_H